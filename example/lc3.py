@@ -9,9 +9,10 @@ class ilc3_coder(Structure):
     _fields_ = [
         ("bitrate", c_uint32),
         ("samplesiz", c_uint32),
-        ("srate_hz", c_uint16),
+        ("srate_hz", c_uint32),
         ("frame_us", c_float),
         ("nch", c_uint8),
+        ("pool", c_void_p),
     ]
 
 
@@ -63,16 +64,21 @@ class LC3:
         stream wav convert to stream lc3
         '''
         in_siz = len(instream)
-        # do output space eqaul size
-        # because can't caluculate compressed size
-        outstream = (c_char * in_siz)(0)
-
         p_coder = pointer(self.__coder)
+        # the exact size of the compressed stream
+        out_siz = self.__so.lc3_stream_encoded_size(p_coder,
+                                                    instream,
+                                                    in_siz,
+                                                    False)
+        if(ILC3_OK > out_siz):
+            return False
+        outstream = (c_char * out_siz)(0)
+
         encres = self.__so.stream_to_lc3(p_coder,
                                          instream,
                                          in_siz,
                                          outstream,
-                                         in_siz,
+                                         out_siz,
                                          False)
         if(ILC3_OK > encres):
             return False
@@ -89,12 +95,15 @@ class LC3:
         stream lc3 convert to stream wav
         '''
         in_siz = len(instream)
-        out_siz = in_siz * 50
-        # do output space size mul on 50
-        # because can't caluculate decompressed size
+        p_coder = pointer(self.__coder)
+        # the exact size of the decompressed stream
+        out_siz = self.__so.lc3_stream_decoded_size(p_coder,
+                                                    instream,
+                                                    in_siz)
+        if(ILC3_OK > out_siz):
+            return False
         outstream = (c_char * out_siz)(0)
 
-        p_coder = pointer(self.__coder)
         decres = self.__so.lc3_to_stream(p_coder,
                                          instream,
                                          in_siz,
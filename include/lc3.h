@@ -46,24 +46,22 @@
  *
  * --- About 44.1 KHz samplerate ---
  *
- * The Bluetooth specification reference the 44.1 KHz samplerate, although
- * there is no support in the core algorithm of the codec of 44.1 KHz.
- * We can summarize the 44.1 KHz support by "you can put any samplerate
- * around the defined base samplerates". Please mind the following items :
+ * The Bluetooth specification codes the 44.1 KHz samplerate with the
+ * configuration of the 48 KHz samplerate, the 44.1 KHz samplerate can be
+ * given as is to the encoder and decoder. Please mind the following items :
  *
- *   1. The frame size will not be 7.5 ms or 10 ms, but is scaled
- *      by 'supported samplerate' / 'input samplerate'
- *
- *   2. The bandwidth will be hard limited (to 20 KHz) if you select 48 KHz.
- *      The encoded bandwidth will also be affected by the above inverse
- *      factor of 20 KHz.
+ *   1. The frame size is the one of 48 KHz, the frames do not last
+ *      7.5 ms or 10 ms, but are scaled by 48 KHz / 44.1 KHz :
+ *      About  8.16 ms frame duration, instead of 7.5 ms
+ *      About 10.88 ms frame duration, instead of  10 ms
  *
- * Applied to 44.1 KHz, we get :
+ *   2. The bandwidth is hard limited to 18.375 KHz, instead of 20 KHz
  *
- *   1. About  8.16 ms frame duration, instead of 7.5 ms
- *      About 10.88 ms frame duration, instead of  10 ms
+ *   3. The bitrate to size of frames conversions depend on the samplerate,
+ *      see `lc3_frame_bytes_ex()` and `lc3_resolve_bitrate_ex()`
  *
- *   2. The bandwidth becomes limited to 18.375 KHz
+ *   4. The 44.1 KHz samplerate cannot be used with the downsampling
+ *      options of the encoder and decoder, with the other samplerates
  *
  *
  * --- How to encode / decode ---
@@ -150,7 +148,7 @@ extern "C" {
 
 #define LC3_CHECK_SR_HZ(sr) \
     ( ((sr) ==  8000) || ((sr) == 16000) || ((sr) == 24000) || \
-      ((sr) == 32000) || ((sr) == 48000)                       )
+      ((sr) == 32000) || ((sr) == 44100) || ((sr) == 48000)    )
 
 
 /**
@@ -176,6 +174,7 @@ enum lc3_pcm_format {
 
 typedef struct lc3_encoder *lc3_encoder_t;
 typedef struct lc3_decoder *lc3_decoder_t;
+typedef struct lc3_transcoder *lc3_transcoder_t;
 
 
 /**
@@ -197,7 +196,7 @@ typedef LC3_DECODER_MEM_T(10000, 48000) lc3_decoder_mem_48k_t;
 /**
  * Return the number of PCM samples in a frame
  * dt_us           Frame duration in us, 7500 or 10000
- * sr_hz           Samplerate in Hz, 8000, 16000, 24000, 32000 or 48000
+ * sr_hz           Samplerate in Hz, 8000, 16000, 24000, 32000, 44100 or 48000
  * return          Number of PCM samples, -1 on bad parameters
  */
 int lc3_frame_samples(int dt_us, int sr_hz);
@@ -218,10 +217,32 @@ int lc3_frame_bytes(int dt_us, int bitrate);
  */
 int lc3_resolve_bitrate(int dt_us, int nbytes);
 
+/**
+ * Return the size of frames, from bitrate and samplerate
+ * dt_us           Frame duration in us, 7500 or 10000
+ * sr_hz           Samplerate in Hz, 8000, 16000, 24000, 32000, 44100 or 48000
+ * bitrate         Target bitrate in bit per second
+ * return          The floor size in bytes of the frames, -1 on bad parameters
+ *
+ * The frames last `dt_us`, except at 44.1 KHz where the duration is
+ * scaled by 48 KHz / 44.1 KHz. Otherwise, the result is the one of
+ * `lc3_frame_bytes()`.
+ */
+int lc3_frame_bytes_ex(int dt_us, int sr_hz, int bitrate);
+
+/**
+ * Resolve the bitrate, from the size of frames and samplerate
+ * dt_us           Frame duration in us, 7500 or 10000
+ * sr_hz           Samplerate in Hz, 8000, 16000, 24000, 32000, 44100 or 48000
+ * nbytes          Size in bytes of the frames
+ * return          The according bitrate in bps, -1 on bad parameters
+ */
+int lc3_resolve_bitrate_ex(int dt_us, int sr_hz, int nbytes);
+
 /**
  * Return algorithmic delay, as a number of samples
  * dt_us           Frame duration in us, 7500 or 10000
- * sr_hz           Samplerate in Hz, 8000, 16000, 24000, 32000 or 48000
+ * sr_hz           Samplerate in Hz, 8000, 16000, 24000, 32000, 44100 or 48000
  * return          Number of algorithmic delay samples, -1 on bad parameters
  */
 int lc3_delay_samples(int dt_us, int sr_hz);
@@ -229,7 +250,7 @@ int lc3_delay_samples(int dt_us, int sr_hz);
 /**
  * Return size needed for an encoder
  * dt_us           Frame duration in us, 7500 or 10000
- * sr_hz           Samplerate in Hz, 8000, 16000, 24000, 32000 or 48000
+ * sr_hz           Samplerate in Hz, 8000, 16000, 24000, 32000, 44100 or 48000
  * return          Size of then encoder in bytes, 0 on bad parameters
  *
  * The `sr_hz` parameter is the samplerate of the PCM input stream,
@@ -240,7 +261,7 @@ unsigned lc3_encoder_size(int dt_us, int sr_hz);
 /**
  * Setup encoder
  * dt_us           Frame duration in us, 7500 or 10000
- * sr_hz           Samplerate in Hz, 8000, 16000, 24000, 32000 or 48000
+ * sr_hz           Samplerate in Hz, 8000, 16000, 24000, 32000, 44100 or 48000
  * sr_pcm_hz       Input samplerate, downsampling option of input, or 0
  * mem             Encoder memory space, aligned to pointer type
  * return          Encoder as an handle, NULL on bad parameters
@@ -254,6 +275,34 @@ unsigned lc3_encoder_size(int dt_us, int sr_hz);
 lc3_encoder_t lc3_setup_encoder(
     int dt_us, int sr_hz, int sr_pcm_hz, void *mem);
 
+/**
+ * Setup encoder, with a complexity level
+ * dt_us           Frame duration in us, 7500 or 10000
+ * sr_hz           Samplerate in Hz, 8000, 16000, 24000, 32000, 44100 or 48000
+ * sr_pcm_hz       Input samplerate, downsampling option of input, or 0
+ * complexity      Complexity level of the analysis
+ * mem             Encoder memory space, aligned to pointer type
+ * return          Encoder as an handle, NULL on bad parameters
+ *
+ * As `lc3_setup_encoder()`, which sets up the `LC3_COMPLEXITY_HIGH` level.
+ * The lower levels trade quality for less processing, the frames produced
+ * remain conformant to the specification.
+ */
+lc3_encoder_t lc3_setup_encoder_ex(int dt_us, int sr_hz, int sr_pcm_hz,
+    enum lc3_complexity complexity, void *mem);
+
+/**
+ * Change the complexity level of an encoder
+ * encoder         Handle of the encoder
+ * complexity      Complexity level of the analysis
+ * return          0: On success  -1: Wrong parameters
+ *
+ * The level applies from the next frame encoded, for instance to shed load
+ * while the frames of many streams are encoded.
+ */
+int lc3_set_encoder_complexity(
+    lc3_encoder_t encoder, enum lc3_complexity complexity);
+
 /**
  * Encode a frame
  * encoder         Handle of the encoder
@@ -266,34 +315,100 @@ lc3_encoder_t lc3_setup_encoder(
 int lc3_encode(lc3_encoder_t encoder, enum lc3_pcm_format fmt,
     const void *pcm, int stride, int nbytes, void *out);
 
+/**
+ * Encode a frame for each encoder of a batch
+ * encoders, n     Handles of the encoders, and count
+ * fmt             PCM input format
+ * pcm, stride     Input PCM samples of each encoder, and count between
+ *                 two consecutives
+ * nbytes          Target size, in bytes, of the frame of each encoder
+ * out             Output buffer of each encoder, of `nbytes[]` size
+ * return          0: On success  -1: Wrong parameters
+ *
+ * The encoders shall have been setup with the same frame duration and
+ * samplerates. The frames are processed together, stage by stage, which
+ * keeps the data of a stage in cache, when encoding many streams.
+ * The frames produced are the same as calling `lc3_encode()` in turn.
+ */
+int lc3_encode_batch(lc3_encoder_t const *encoders, int n,
+    enum lc3_pcm_format fmt, const void * const *pcm, int stride,
+    const int *nbytes, void * const *out);
+
+/**
+ * Return the statistics of an encoder
+ * encoder         Handle of the encoder
+ * stats           Return the statistics, accumulated since setup
+ * return          0: On success  -1: Wrong parameters, or the library
+ *                 is not built with `LC3_PROFILE` defined
+ *
+ * The statistics are collected when the library is built with
+ * `LC3_PROFILE` defined (`make PROFILE=1`), otherwise `stats` is zeroed.
+ * The size of the states does not depend on it, so an application can
+ * be built with or without the definition, against either library.
+ */
+int lc3_encoder_stats(lc3_encoder_t encoder, struct lc3_encoder_stats *stats);
+
 /**
  * Return size needed for an decoder
  * dt_us           Frame duration in us, 7500 or 10000
- * sr_hz           Samplerate in Hz, 8000, 16000, 24000, 32000 or 48000
+ * sr_hz           Samplerate in Hz, 8000, 16000, 24000, 32000, 44100 or 48000
  * return          Size of then decoder in bytes, 0 on bad parameters
  *
- * The `sr_hz` parameter is the samplerate of the PCM output stream,
- * and will match `sr_pcm_hz` of `lc3_setup_decoder()`.
+ * The `sr_hz` parameter is the higher of the samplerate of the stream,
+ * and the samplerate of the PCM output `sr_pcm_hz` of `lc3_setup_decoder()`.
  */
 unsigned lc3_decoder_size(int dt_us, int sr_hz);
 
 /**
  * Setup decoder
  * dt_us           Frame duration in us, 7500 or 10000
- * sr_hz           Samplerate in Hz, 8000, 16000, 24000, 32000 or 48000
- * sr_pcm_hz       Output samplerate, upsampling option of output (or 0)
+ * sr_hz           Samplerate in Hz, 8000, 16000, 24000, 32000, 44100 or 48000
+ * sr_pcm_hz       Output samplerate, resampling option of output (or 0)
  * mem             Decoder memory space, aligned to pointer type
  * return          Decoder as an handle, NULL on bad parameters
  *
- * The `sr_pcm_hz` parameter is an upsampling option of PCM output,
+ * The `sr_pcm_hz` parameter is a resampling option of PCM output,
  * the value `0` fallback to the samplerate of the decoded stream `sr_hz`.
- * When used, `sr_pcm_hz` is intended to be higher or equal to the decoder
- * samplerate `sr_hz`. The size of the context needed, given by
- * `lc3_decoder_size()` will be set accordingly to `sr_pcm_hz`.
+ * When higher than `sr_hz`, the output is upsampled. When lower, the
+ * spectrum is truncated to the bandwidth of the output, and the synthesis
+ * runs at `sr_pcm_hz`, lowering the cost of the decoding.
+ * The size of the context needed, given by `lc3_decoder_size()` will be
+ * set accordingly to the higher of `sr_hz` and `sr_pcm_hz`.
  */
 lc3_decoder_t lc3_setup_decoder(
     int dt_us, int sr_hz, int sr_pcm_hz, void *mem);
 
+/**
+ * Return size needed for a compact decoder
+ * dt_us           Frame duration in us, 7500 or 10000
+ * sr_hz           Samplerate in Hz, 8000, 16000, 24000, 32000, 44100 or 48000
+ * return          Size of then decoder in bytes, 0 on bad parameters
+ *
+ * As `lc3_decoder_size()`, for a decoder setup by
+ * `lc3_setup_decoder_compact()`.
+ */
+unsigned lc3_decoder_size_compact(int dt_us, int sr_hz);
+
+/**
+ * Setup compact decoder
+ * dt_us           Frame duration in us, 7500 or 10000
+ * sr_hz           Samplerate in Hz, 8000, 16000, 24000, 32000, 44100 or 48000
+ * sr_pcm_hz       Output samplerate, resampling option of output (or 0)
+ * mem             Decoder memory space, aligned to pointer type
+ * return          Decoder as an handle, NULL on bad parameters
+ *
+ * The compact decoder keeps the 18 ms of output history, read back by
+ * the Long Term Postfilter, as 16 bits samples instead of float samples,
+ * and only the current frame as float samples. The memory is reduced by
+ * about a quarter (48 KHz, 10 ms) to a third (7.5 ms), the history being
+ * widened only for the frames the postfilter is active.
+ * The output differs from `lc3_setup_decoder()` one by the rounding
+ * of the history, below the 16 bits resolution.
+ * The size of the context needed is given by `lc3_decoder_size_compact()`.
+ */
+lc3_decoder_t lc3_setup_decoder_compact(
+    int dt_us, int sr_hz, int sr_pcm_hz, void *mem);
+
 /**
  * Decode a frame
  * decoder         Handle of the decoder
@@ -305,6 +420,168 @@ lc3_decoder_t lc3_setup_decoder(
 int lc3_decode(lc3_decoder_t decoder, const void *in, int nbytes,
     enum lc3_pcm_format fmt, void *pcm, int stride);
 
+/**
+ * Decode a frame for each decoder of a batch
+ * decoders, n     Handles of the decoders, and count
+ * in, nbytes      Input bitstream of each decoder, and size in bytes,
+ *                 a NULL bitstream (or `in` array) performs PLC,
+ *                 `nbytes` can be NULL when `in` is NULL
+ * fmt             PCM output format
+ * pcm, stride     Output PCM samples of each decoder, and count between
+ *                 two consecutives
+ * status          When not NULL, return the status of each decoder,
+ *                 0: Decoded  1: PLC operated
+ * return          Number of PLC operated, -1 on wrong parameters
+ *
+ * The decoders shall have been setup with the same frame duration and
+ * samplerates. As for `lc3_encode_batch()`, the frames are processed
+ * together, stage by stage.
+ */
+int lc3_decode_batch(lc3_decoder_t const *decoders, int n,
+    const void * const *in, const int *nbytes,
+    enum lc3_pcm_format fmt, void * const *pcm, int stride, int *status);
+
+/**
+ * Return the statistics of a decoder
+ * decoder         Handle of the decoder
+ * stats           Return the statistics, accumulated since setup
+ * return          0: On success  -1: Wrong parameters, or the library
+ *                 is not built with `LC3_PROFILE` defined
+ *
+ * As for `lc3_encoder_stats()`, `stats` is zeroed when the library is
+ * not built with `LC3_PROFILE` defined.
+ */
+int lc3_decoder_stats(lc3_decoder_t decoder, struct lc3_decoder_stats *stats);
+
+/**
+ * Side data of a frame, returned by `lc3_parse_frame()`
+ *   bandwidth_hz    Bandwidth coded, 4000, 8000, 12000, 16000 or 20000 Hz
+ *                   scaled by 44.1 KHz / 48 KHz at 44.1 KHz
+ *   g_idx           Global gain index (0 to 255)
+ *   nq, lsb_mode    Count of coded spectral coefficients, and LSB mode
+ *   pitch_present   Pitch (LTPF) data present
+ *   ltpf_active     LTPF activated, and its pitch index (when present)
+ *   tns_nfilters    Number of TNS filters (1 or 2), and their orders
+ *   noise_factor    Noise filling level (0 to 7)
+ */
+struct lc3_frame_info {
+    int bandwidth_hz;
+    int g_idx;
+    int nq;
+    bool lsb_mode;
+    bool pitch_present;
+    bool ltpf_active;
+    int pitch_index;
+    int tns_nfilters;
+    int tns_order[2];
+    int noise_factor;
+};
+
+/**
+ * Parse a frame, without decoding it
+ * dt_us           Frame duration in us, 7500 or 10000
+ * sr_hz           Samplerate in Hz, 8000, 16000, 24000, 32000, 44100 or 48000
+ * in, nbytes      Input bitstream, and size in bytes
+ * info            Return the side data of the frame, or NULL
+ * return          0: Valid frame  1: Invalid frame  -1: Wrong parameters
+ *
+ * The side data and the spectrum are parsed as by `lc3_decode()`, which
+ * operates PLC on the frames reported invalid. The synthesis is not run,
+ * and no decoder is needed, which makes the validation of recorded
+ * streams a fraction of their decoding.
+ */
+int lc3_parse_frame(int dt_us, int sr_hz,
+    const void *in, int nbytes, struct lc3_frame_info *info);
+
+/**
+ * Return size needed for a transcoder
+ * dt_us           Frame duration in us, 7500 or 10000
+ * sr_hz           Samplerate in Hz, 8000, 16000, 24000, 32000, 44100 or 48000
+ * return          Size of the transcoder in bytes, 0 on bad parameters
+ */
+unsigned lc3_transcoder_size(int dt_us, int sr_hz);
+
+/**
+ * Setup transcoder
+ * dt_us           Frame duration in us, 7500 or 10000
+ * sr_hz           Samplerate in Hz, 8000, 16000, 24000, 32000, 44100 or 48000
+ * mem             Transcoder memory space, aligned to pointer type
+ * return          Transcoder as an handle, NULL on bad parameters
+ *
+ * A transcoder changes the size of the frames of a stream, and keeps
+ * the state of the rate control of the output stream. A transcoder
+ * is needed for each size of the frames output.
+ */
+lc3_transcoder_t lc3_setup_transcoder(int dt_us, int sr_hz, void *mem);
+
+/**
+ * Transcode a frame
+ * transcoder      Handle of the transcoder
+ * in, nbytes_in   Input bitstream, and size in bytes
+ * nbytes          Size in bytes of the output frame
+ * out             Output bitstream buffer, of `nbytes` size
+ * return          0: On success  1: Invalid input frame  -1: Wrong parameters
+ *
+ * The frame is decoded to the spectral domain, and only the spectrum is
+ * coded again at the new size. The bandwidth, SNS, TNS and LTPF data of
+ * the input frame are kept, the transforms and the analysis of the
+ * encoding are not run. No output is produced from an invalid frame,
+ * which should be signaled as lost to the receiver (PLC).
+ */
+int lc3_transcode(lc3_transcoder_t transcoder,
+    const void *in, int nbytes_in, int nbytes, void *out);
+
+/**
+ * Transcode a frame to several sizes
+ * transcoders, n  Handles of the transcoders, and count (at least 1)
+ * in, nbytes_in   Input bitstream, and size in bytes
+ * nbytes          Size in bytes of the output frame of each transcoder
+ * out             Output bitstream buffer of each transcoder
+ * return          0: On success  1: Invalid input frame  -1: Wrong parameters
+ *
+ * The transcoders shall have been setup with the same frame duration and
+ * samplerate. The input frame is decoded once, and coded again for each
+ * transcoder, as by `lc3_transcode()`.
+ */
+int lc3_transcode_batch(lc3_transcoder_t const *transcoders, int n,
+    const void *in, int nbytes_in, const int *nbytes, void * const *out);
+
+
+/**
+ * Processor levels of the DSP kernels
+ *   GENERIC  Build options of the library
+ *   SSE4     x86 SSE4.1
+ *   AVX2     x86 AVX2 and FMA
+ *
+ * The level in use is the highest supported by the processor. It can be
+ * forced by the environment variable `LC3_CPU`, set to "generic", "sse4"
+ * or "avx2", or by `lc3_set_cpu_level()`, which takes precedence.
+ * The processor and `LC3_CPU` are read once, by the first setup or call
+ * of the functions below.
+ */
+
+enum lc3_cpu_level {
+    LC3_CPU_GENERIC,
+    LC3_CPU_SSE4,
+    LC3_CPU_AVX2,
+
+    LC3_NUM_CPU_LEVEL
+};
+
+/**
+ * Force the processor level
+ * level           Processor level, -1 restores the automatic selection
+ * return          0: On success  -1: Level not supported by the processor
+ *
+ * The level applies to the encoders and decoders setup afterwards.
+ */
+int lc3_set_cpu_level(int level);
+
+/**
+ * Return the processor level, used by encoders and decoders setup now
+ */
+enum lc3_cpu_level lc3_get_cpu_level(void);
+
 
 #ifdef __cplusplus
 }
@@ -29,6 +29,7 @@
 #include <stdlib.h>
 
 #include "lc3.h"
+#include "lc3_pool.h"
 
 namespace lc3 {
 
@@ -50,11 +51,13 @@ enum class PcmFormat {
 template <typename T>
 class Base {
  protected:
-  Base(int dt_us, int sr_hz, int sr_pcm_hz, size_t nchannels)
+  Base(int dt_us, int sr_hz, int sr_pcm_hz, size_t nchannels,
+       lc3_pool_t pool)
       : dt_us_(dt_us),
         sr_hz_(sr_hz),
         sr_pcm_hz_(sr_pcm_hz == 0 ? sr_hz : sr_pcm_hz),
-        nchannels_(nchannels) {
+        nchannels_(nchannels),
+        pool_(pool) {
     states.reserve(nchannels_);
   }
 
@@ -63,8 +66,16 @@ class Base {
   int dt_us_, sr_hz_;
   int sr_pcm_hz_;
   size_t nchannels_;
+  lc3_pool_t pool_;
 
-  using state_ptr = std::unique_ptr<T, decltype(&free)>;
+  // The states are given back to the pool, or freed without pool
+
+  struct StateDeleter {
+    lc3_pool_t pool;
+    void operator()(T *s) const { lc3_pool_put(pool, s); }
+  };
+
+  using state_ptr = std::unique_ptr<T, StateDeleter>;
   std::vector<state_ptr> states;
 
  public:
@@ -72,10 +83,14 @@ class Base {
   int GetFrameSamples() { return lc3_frame_samples(dt_us_, sr_pcm_hz_); }
 
   // Return the size of frames, from bitrate
-  int GetFrameBytes(int bitrate) { return lc3_frame_bytes(dt_us_, bitrate); }
+  int GetFrameBytes(int bitrate) {
+    return lc3_frame_bytes_ex(dt_us_, sr_hz_, bitrate);
+  }
 
   // Resolve the bitrate, from the size of frames
-  int ResolveBitrate(int nbytes) { return lc3_resolve_bitrate(dt_us_, nbytes); }
+  int ResolveBitrate(int nbytes) {
+    return lc3_resolve_bitrate_ex(dt_us_, sr_hz_, nbytes);
+  }
 
   // Return algorithmic delay, as a number of samples
   int GetDelaySamples() { return lc3_delay_samples(dt_us_, sr_pcm_hz_); }
@@ -102,18 +117,22 @@ class Encoder : public Base<struct lc3_encoder> {
   // Encoder construction / destruction
   //
   // The frame duration `dt_us` is 7500 or 10000 us.
-  // The samplerate `sr_hz` is 8000, 16000, 24000, 32000 or 48000 Hz.
+  // The samplerate `sr_hz` is 8000, 16000, 24000, 32000, 44100 or 48000 Hz.
   //
   // The `sr_pcm_hz` parameter is a downsampling option of PCM input,
   // the value 0 fallback to the samplerate of the encoded stream `sr_hz`.
   // When used, `sr_pcm_hz` is intended to be higher or equal to the encoder
   // samplerate `sr_hz`.
+  //
+  // The states of the channels are taken from `pool`, when given, which
+  // is not owned and shall outlive the encoder (see `lc3_pool.h`).
 
-  Encoder(int dt_us, int sr_hz, int sr_pcm_hz = 0, size_t nchannels = 1)
-      : Base(dt_us, sr_hz, sr_pcm_hz, nchannels) {
+  Encoder(int dt_us, int sr_hz, int sr_pcm_hz = 0, size_t nchannels = 1,
+          lc3_pool_t pool = nullptr)
+      : Base(dt_us, sr_hz, sr_pcm_hz, nchannels, pool) {
     for (size_t ich = 0; ich < nchannels_; ich++) {
-      auto s = state_ptr(
-          (lc3_encoder_t)malloc(lc3_encoder_size(dt_us_, sr_pcm_hz_)), free);
+      auto s = state_ptr((lc3_encoder_t)lc3_pool_get(
+          pool_, lc3_encoder_size(dt_us_, sr_pcm_hz_)), {pool_});
 
       if (lc3_setup_encoder(dt_us_, sr_hz_, sr_pcm_hz_, s.get()))
         states.push_back(std::move(s));
@@ -200,18 +219,22 @@ class Decoder : public Base<struct lc3_decoder> {
   // Decoder construction / destruction
   //
   // The frame duration `dt_us` is 7500 or 10000 us.
-  // The samplerate `sr_hz` is 8000, 16000, 24000, 32000 or 48000 Hz.
+  // The samplerate `sr_hz` is 8000, 16000, 24000, 32000, 44100 or 48000 Hz.
   //
   // The `sr_pcm_hz` parameter is an downsampling option of PCM output,
   // the value 0 fallback to the samplerate of the decoded stream `sr_hz`.
   // When used, `sr_pcm_hz` is intended to be higher or equal to the decoder
   // samplerate `sr_hz`.
+  //
+  // The states of the channels are taken from `pool`, when given, which
+  // is not owned and shall outlive the decoder (see `lc3_pool.h`).
 
-  Decoder(int dt_us, int sr_hz, int sr_pcm_hz = 0, size_t nchannels = 1)
-      : Base(dt_us, sr_hz, sr_pcm_hz, nchannels) {
+  Decoder(int dt_us, int sr_hz, int sr_pcm_hz = 0, size_t nchannels = 1,
+          lc3_pool_t pool = nullptr)
+      : Base(dt_us, sr_hz, sr_pcm_hz, nchannels, pool) {
     for (size_t i = 0; i < nchannels_; i++) {
-      auto s = state_ptr(
-          (lc3_decoder_t)malloc(lc3_decoder_size(dt_us_, sr_pcm_hz_)), free);
+      auto s = state_ptr((lc3_decoder_t)lc3_pool_get(
+          pool_, lc3_decoder_size(dt_us_, sr_pcm_hz_)), {pool_});
 
       if (lc3_setup_decoder(dt_us_, sr_hz_, sr_pcm_hz_, s.get()))
         states.push_back(std::move(s));
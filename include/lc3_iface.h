@@ -3,13 +3,25 @@
 #include "stdint.h"
 #include <stdint.h>
 #include <stdbool.h>
+#include <lc3.h>
+#include <lc3_pool.h>
+
+/**
+ * PCM samplerates of the coders, the LC3 samplerates are coded as is,
+ * the others are resampled from and to an LC3 samplerate
+ */
+#define ILC3_CHECK_SR_HZ(sr) \
+    ( LC3_CHECK_SR_HZ(sr) || \
+      (sr) == 11025 || (sr) == 22050 || \
+      (sr) == 88200 || (sr) == 96000 )
 
 typedef struct ilc3_coder {
     uint32_t bitrate;
     uint32_t samplesiz;
-    uint16_t srate_hz;
+    uint32_t srate_hz;
     float frame_us;
     uint8_t nch;
+    lc3_pool_t pool;
 } ilc3_coder_t;
 
 typedef enum {
@@ -23,12 +35,15 @@ typedef enum {
 
 /**
  * init encoder/decoder struct
+ *
+ * the states of the channels are allocated from the heap, a pool
+ * of slots sized for them can be given after in 'pool' (see lc3_pool.h)
 */
 extern
 ilc3_res_t lc3_coder_init(ilc3_coder_t * const enc,
                           const uint32_t bitrate,
                           const uint32_t samplesiz,
-                          const uint16_t srate_hz,
+                          const uint32_t srate_hz,
                           const uint8_t nch,
                           const float frame_us);
 
@@ -39,6 +54,8 @@ ilc3_res_t lc3_coder_init(ilc3_coder_t * const enc,
  * @param fin - [in] input file name or NULL for use stdin
  * @param fout - [in] output file name or NULL for use stdout
  * 
+ * regular files are memory-mapped, others are read and written by stdio
+ * 
  * @return error codes
 */
 extern
@@ -48,6 +65,7 @@ ilc3_res_t file_wav_to_lc3(const ilc3_coder_t * const enc,
 
 /**
  * convert 'fin' lc3 file to wav and put all data to 'fout'
+ * regular files are memory-mapped, others are read and written by stdio
  * return error codes
 */
 extern
@@ -79,4 +97,27 @@ ilc3_res_t lc3_to_stream(ilc3_coder_t * const dec,
                          uint8_t * const out,
                          const uint32_t out_siz);
 
+
+/**
+ * return the exact size of the lc3 stream produced by `stream_to_lc3`
+ * with the same parameters, only the wave header is parsed
+ * return size in bytes or error codes
+*/
+extern
+ilc3_res_t lc3_stream_encoded_size(const ilc3_coder_t * const encoder,
+                                   const uint8_t * const fin,
+                                   const uint32_t in_siz,
+                                   const bool with_hdr);
+
+
+/**
+ * return the exact size of the wave stream produced by `lc3_to_stream`
+ * with the same parameters, only the lc3 header is parsed
+ * return size in bytes or error codes
+*/
+extern
+ilc3_res_t lc3_stream_decoded_size(const ilc3_coder_t * const decoder,
+                                   const uint8_t * const fin,
+                                   const uint32_t in_siz);
+
 #endif//LC3_IFACE_H
\ No newline at end of file
@@ -0,0 +1,104 @@
+/******************************************************************************
+ *
+ *  Copyright 2022 Google LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/**
+ * LC3 - Multichannel encoder, spreading channels over worker threads
+ *
+ * The channels of an LC3 stream are encoded independently. The
+ * multichannel encoder owns an `lc3_encoder` state by channel, and a
+ * persistent pool of worker threads. A call of `lc3_mt_encode()` hands
+ * out the channels of the frame to the workers, and returns when all the
+ * channels are encoded (a barrier by frame).
+ *
+ * The calling thread takes part in the encoding, so a pool of `nthreads`
+ * spawns `nthreads - 1` worker threads. The channel `ich` is always
+ * encoded by the thread `ich % nthreads`.
+ *
+ *   | lc3_mt_encoder_t encoder = lc3_mt_setup_encoder(
+ *   |     dt_us, sr_hz, 0, nch, nthreads);
+ *   |
+ *   | for each frame of `lc3_frame_samples()` interleaved samples
+ *   |     lc3_mt_encode(encoder, LC3_PCM_FORMAT_S16, pcm, nbytes, out);
+ *   |
+ *   | lc3_mt_free_encoder(encoder);
+ */
+
+#ifndef __LC3_MT_H
+#define __LC3_MT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "lc3.h"
+
+
+/**
+ * Handle
+ */
+
+typedef struct lc3_mt_encoder *lc3_mt_encoder_t;
+
+
+/**
+ * Setup multichannel encoder
+ * dt_us           Frame duration in us, 7500 or 10000
+ * sr_hz           Samplerate in Hz, 8000, 16000, 24000, 32000, 44100 or 48000
+ * sr_pcm_hz       Input samplerate, downsampling option of input, or 0
+ * nch             Number of channels, 1 or more
+ * nthreads        Number of threads, including the caller, 0 for `nch`
+ * return          Encoder as an handle, NULL on bad parameters or
+ *                 when the allocation of resources failed
+ *
+ * The number of threads is limited to the number of channels.
+ */
+lc3_mt_encoder_t lc3_mt_setup_encoder(
+    int dt_us, int sr_hz, int sr_pcm_hz, int nch, int nthreads);
+
+/**
+ * Free multichannel encoder, terminating the worker threads
+ * encoder         Handle of the encoder, NULL is ignored
+ */
+void lc3_mt_free_encoder(lc3_mt_encoder_t encoder);
+
+/**
+ * Return the number of channels of a multichannel encoder
+ * encoder         Handle of the encoder
+ * return          Number of channels, -1 on wrong parameters
+ */
+int lc3_mt_encoder_channels(lc3_mt_encoder_t encoder);
+
+/**
+ * Encode a multichannel frame
+ * encoder         Handle of the encoder
+ * fmt             PCM input format
+ * pcm             Input PCM samples, channels interleaved
+ * nbytes          Target size, in bytes, of the frame of a channel (20 to 400)
+ * out             Output buffer of `nch * nbytes` size, the frame of the
+ *                 channel `ich` is written at offset `ich * nbytes`
+ * return          0: On success  -1: Wrong parameters
+ */
+int lc3_mt_encode(lc3_mt_encoder_t encoder,
+    enum lc3_pcm_format fmt, const void *pcm, int nbytes, void *out);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LC3_MT_H */
@@ -0,0 +1,132 @@
+/******************************************************************************
+ *
+ *  Copyright 2022 Google LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/**
+ * LC3 - Pool of encoder and decoder states
+ *
+ * A pool hands out slots of a fixed size, aligned on cache lines
+ * (`LC3_POOL_ALIGN` bytes), carved out of large slabs mapped on demand.
+ * The slots are sized for the largest state to hold, as returned by
+ * `lc3_encoder_size()` or `lc3_decoder_size()`, and hold the memory
+ * given to `lc3_setup_encoder()` or `lc3_setup_decoder()`.
+ *
+ * Taking and giving back a slot are constant time operations, the slots
+ * given back are reused first. The slabs are only released with the pool.
+ *
+ *   | lc3_pool_t pool = lc3_pool_setup(
+ *   |     lc3_encoder_size(10000, 48000), 0, LC3_POOL_HUGEPAGES, -1);
+ *   |
+ *   | for each channel joining
+ *   |     lc3_encoder_t enc = lc3_setup_encoder(dt_us, sr_hz, 0,
+ *   |         lc3_pool_get(pool, lc3_encoder_size(dt_us, sr_hz)));
+ *   |
+ *   | for each channel leaving
+ *   |     lc3_pool_put(pool, enc);
+ *   |
+ *   | lc3_pool_free(pool);
+ *
+ * A pool is not thread-safe, the intended use is a pool by thread, which
+ * also keeps the states local to the NUMA node running the thread.
+ */
+
+#ifndef __LC3_POOL_H
+#define __LC3_POOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "lc3.h"
+
+
+/**
+ * Alignment in bytes of the slots
+ */
+
+#define LC3_POOL_ALIGN  64
+
+/**
+ * Options of the slabs
+ *   HUGEPAGES    Back the slabs by huge pages, when reserved by the system
+ *                (`MAP_HUGETLB`), or else by transparent huge pages
+ */
+
+#define LC3_POOL_HUGEPAGES  (1 << 0)
+
+
+/**
+ * Handle
+ */
+
+typedef struct lc3_pool *lc3_pool_t;
+
+
+/**
+ * Setup a pool
+ * slot_size       Size in bytes of the slots
+ * slab_size       Size in bytes of the slabs, 0 for the default of 2 MB,
+ *                 rounded up to the size of the pages
+ * flags           Options of the slabs, `LC3_POOL_*` combined
+ * numa_node       NUMA node preferred for the slabs, -1 for no preference
+ * return          Pool as an handle, NULL on bad parameters or
+ *                 when the allocation failed
+ *
+ * The pages of the slabs are taken from the preferred NUMA node, or from
+ * the other nodes when it's exhausted. The preference is ignored when
+ * not supported by the system.
+ */
+lc3_pool_t lc3_pool_setup(
+    unsigned slot_size, unsigned slab_size, int flags, int numa_node);
+
+/**
+ * Free a pool, and its slabs
+ * pool            Handle of the pool, NULL is ignored
+ *
+ * The slots are released with the pool, without being given back.
+ */
+void lc3_pool_free(lc3_pool_t pool);
+
+/**
+ * Return the size of the slots of a pool
+ * pool            Handle of the pool
+ * return          Size in bytes of the slots, 0 on wrong parameters
+ */
+unsigned lc3_pool_slot_size(lc3_pool_t pool);
+
+/**
+ * Take a slot of a pool
+ * pool            Handle of the pool, or NULL to allocate from the heap
+ * size            Size in bytes needed, within the size of the slots
+ * return          Memory of the slot, NULL when the size does not fit,
+ *                 or when a new slab can't be mapped
+ */
+void *lc3_pool_get(lc3_pool_t pool, unsigned size);
+
+/**
+ * Give back a slot to its pool
+ * pool            Handle of the pool, or NULL when allocated from the heap
+ * mem             Memory of the slot, NULL is ignored
+ */
+void lc3_pool_put(lc3_pool_t pool, void *mem);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LC3_POOL_H */
@@ -28,21 +28,29 @@
  * encoded spectrum coefficients within a frame
  * - For encoding, keep 1.25 ms of temporal winodw
  * - For decoding, keep 18 ms of history, aligned on frames, and a frame
+ * - For compact decoding, keep only the 18 ms of history
+ * - The 44.1 KHz samplerate takes the number of samples of 48 KHz
  */
 
+#define __LC3_SR_HZ(sr_hz) \
+    ( (sr_hz) == 44100 ? 48000 : (sr_hz) )
+
 #define __LC3_NS(dt_us, sr_hz) \
-    ( (dt_us * sr_hz) / 1000 / 1000 )
+    ( (dt_us * __LC3_SR_HZ(sr_hz)) / 1000 / 1000 )
 
 #define __LC3_ND(dt_us, sr_hz) \
     ( (dt_us) == 7500 ? 23 * __LC3_NS(dt_us, sr_hz) / 30 \
                       :  5 * __LC3_NS(dt_us, sr_hz) /  8 )
 
 #define __LC3_NT(sr_hz) \
-    ( (5 * sr_hz) / 4000 )
+    ( (5 * __LC3_SR_HZ(sr_hz)) / 4000 )
 
 #define __LC3_NH(dt_us, sr_hz) \
     ( ((3 - ((dt_us) >= 10000)) + 1) * __LC3_NS(dt_us, sr_hz) )
 
+#define __LC3_NL(sr_hz) \
+    ( (18 * __LC3_SR_HZ(sr_hz)) / 1000 )
+
 
 /**
  * Frame duration 7.5ms or 10ms
@@ -70,6 +78,39 @@ enum lc3_srate {
 };
 
 
+/**
+ * Statistics of the encoders, collected with `LC3_PROFILE` defined
+ * The statistics take place in the states whether collected or not,
+ * keeping the size of the states independent of the build options
+ * - The stages of the analysis, and the bitstream encoding
+ * - The count of frames encoded, with LTPF active, and
+ *   with the first and second TNS filters in use
+ * - The cycles spent in each stage
+ */
+
+enum lc3_encoder_stage {
+    LC3_ENCODER_STAGE_ATTDET,
+    LC3_ENCODER_STAGE_LTPF,
+    LC3_ENCODER_STAGE_MDCT,
+    LC3_ENCODER_STAGE_ENERGY,
+    LC3_ENCODER_STAGE_BWDET,
+    LC3_ENCODER_STAGE_SNS,
+    LC3_ENCODER_STAGE_TNS,
+    LC3_ENCODER_STAGE_SPEC,
+    LC3_ENCODER_STAGE_ENCODE,
+
+    LC3_NUM_ENCODER_STAGE
+};
+
+struct lc3_encoder_stats {
+    unsigned frames;
+    unsigned ltpf_active;
+    unsigned tns_filters[2];
+
+    uint64_t cycles[LC3_NUM_ENCODER_STAGE];
+};
+
+
 /**
  * Encoder state and memory
  */
@@ -99,14 +140,36 @@ typedef struct lc3_spec_analysis {
     int nbits_spare;
 } lc3_spec_analysis_t;
 
+/**
+ * Complexity of the encoders analysis
+ *   HIGH     Complete analysis, the default
+ *   MEDIUM   The pitch detection of LTPF tracks a stable pitch, around the
+ *            previous one, and the TNS analysis is skipped on frames
+ *            with a spectrum far from flat
+ *   LOW      Moreover, the global gain is adjusted after the first
+ *            quantization of the spectrum, only when out of budget
+ */
+
+enum lc3_complexity {
+    LC3_COMPLEXITY_HIGH,
+    LC3_COMPLEXITY_MEDIUM,
+    LC3_COMPLEXITY_LOW,
+
+    LC3_NUM_COMPLEXITY
+};
+
 struct lc3_encoder {
     enum lc3_dt dt;
     enum lc3_srate sr, sr_pcm;
+    enum lc3_complexity complexity;
+    const struct lc3_cpu_ops *cpu;
 
     lc3_attdet_analysis_t attdet;
     lc3_ltpf_analysis_t ltpf;
     lc3_spec_analysis_t spec;
 
+    struct lc3_encoder_stats stats;
+
     int xt_off, xs_off, xd_off;
     float x[1];
 };
@@ -122,6 +185,37 @@ struct lc3_encoder {
     }
 
 
+/**
+ * Statistics of the decoders, collected with `LC3_PROFILE` defined
+ * - The stages of the bitstream decoding, and the synthesis
+ * - The count of frames decoded, concealed by PLC, of bitstream
+ *   errors detected, with LTPF active, and with the first and
+ *   second TNS filters in use
+ * - The cycles spent in each stage
+ */
+
+enum lc3_decoder_stage {
+    LC3_DECODER_STAGE_DECODE,
+    LC3_DECODER_STAGE_TNS,
+    LC3_DECODER_STAGE_PLC,
+    LC3_DECODER_STAGE_SNS,
+    LC3_DECODER_STAGE_MDCT,
+    LC3_DECODER_STAGE_LTPF,
+
+    LC3_NUM_DECODER_STAGE
+};
+
+struct lc3_decoder_stats {
+    unsigned frames;
+    unsigned plc_frames;
+    unsigned bits_errors;
+    unsigned ltpf_active;
+    unsigned tns_filters[2];
+
+    uint64_t cycles[LC3_NUM_DECODER_STAGE];
+};
+
+
 /**
  * Decoder state and memory
  */
@@ -141,11 +235,16 @@ typedef struct lc3_plc_state {
 struct lc3_decoder {
     enum lc3_dt dt;
     enum lc3_srate sr, sr_pcm;
+    const struct lc3_cpu_ops *cpu;
 
     lc3_ltpf_synthesis_t ltpf;
     lc3_plc_state_t plc;
 
-    int xh_off, xs_off, xd_off, xg_off;
+    struct lc3_decoder_stats stats;
+
+    bool compact;
+    int xh_off, xs_off, xd_off, xg_off, xf_off;
+    int xl_off, xl_pos;
     float x[1];
 };
 
@@ -153,6 +252,15 @@ struct lc3_decoder {
     ( __LC3_NH(dt_us, sr_hz) + __LC3_ND(dt_us, sr_hz) + \
       __LC3_NS(dt_us, sr_hz) )
 
+/**
+ * The compact decoder keeps the history in 16 bits samples,
+ * following the buffers of the frame, and counted in floats
+ */
+
+#define LC3_DECODER_COMPACT_BUFFER_COUNT(dt_us, sr_hz) \
+    ( 2 * __LC3_NS(dt_us, sr_hz) + __LC3_ND(dt_us, sr_hz) + \
+      (__LC3_NL(sr_hz) + 1) / 2 )
+
 #define LC3_DECODER_MEM_T(dt_us, sr_hz) \
     struct { \
         struct lc3_decoder __d; \
@@ -160,4 +268,17 @@ struct lc3_decoder {
     }
 
 
+/**
+ * Transcoder state
+ */
+
+struct lc3_transcoder {
+    enum lc3_dt dt;
+    enum lc3_srate sr;
+    const struct lc3_cpu_ops *cpu;
+
+    lc3_spec_analysis_t spec;
+};
+
+
 #endif /* __LC3_PRIVATE_H */
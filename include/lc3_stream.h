@@ -0,0 +1,243 @@
+/******************************************************************************
+ *
+ *  Copyright 2022 Google LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/**
+ * LC3 - Incremental stream encoding and decoding
+ *
+ * Encoding
+ * --------
+ *
+ * The stream encoder takes interleaved PCM in chunks of any size, and
+ * produces the records of the LC3 binary format (see `lc3_header.h`) :
+ * a 16 bits size, followed by the frames of the channels.
+ *
+ * Each record is written in a slot of `lc3_stream_encoder_slot_size()`
+ * bytes, provided by the caller, for instance the free part of a ring
+ * buffer. The frames are encoded directly from the input chunks, only
+ * the samples of a frame split between two chunks are kept internally.
+ *
+ *   | lc3_stream_encoder_t encoder = lc3_stream_setup_encoder(
+ *   |     dt_us, sr_hz, 0, nch, bitrate, LC3_PCM_FORMAT_S16);
+ *   |
+ *   | lc3_stream_encoder_header(encoder, nsamples, header);
+ *   |
+ *   | for each chunk of `size` bytes
+ *   |     while (size > 0)
+ *   |         n = lc3_stream_encode(encoder,
+ *   |             pcm, size, &consumed, slots, nslots);
+ *   |         pcm += consumed, size -= consumed;
+ *   |         ... `n` records available in `slots` ...
+ *   |
+ *   | while ((n = lc3_stream_encoder_flush(encoder, slots, nslots)) > 0)
+ *   |     ... `n` records available in `slots` ...
+ *   |
+ *   | lc3_stream_free_encoder(encoder);
+ *
+ * Decoding
+ * --------
+ *
+ * The stream decoder takes the LC3 binary format in chunks of any size,
+ * the header then the records, and decodes a frame as soon as its record
+ * is complete. The input is no longer consumed while the PCM samples of
+ * the decoded frame are pending, waiting to be pulled.
+ *
+ *   | lc3_stream_decoder_t decoder = lc3_stream_setup_decoder(
+ *   |     0, LC3_PCM_FORMAT_S16);
+ *   |
+ *   | for each chunk of `size` bytes
+ *   |     while (size > 0)
+ *   |         n = lc3_stream_decoder_push(decoder, in, size);
+ *   |         in += n, size -= n;
+ *   |         while ((n = lc3_stream_decoder_pending(decoder)) > 0)
+ *   |             lc3_stream_decoder_pull(decoder, pcm, n);
+ *   |
+ *   | lc3_stream_decoder_end(decoder);
+ *   | while ((n = lc3_stream_decoder_pending(decoder)) > 0)
+ *   |     lc3_stream_decoder_pull(decoder, pcm, n);
+ *   |
+ *   | lc3_stream_free_decoder(decoder);
+ */
+
+#ifndef __LC3_STREAM_H
+#define __LC3_STREAM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "lc3.h"
+
+
+/**
+ * Handle
+ */
+
+typedef struct lc3_stream_encoder *lc3_stream_encoder_t;
+typedef struct lc3_stream_decoder *lc3_stream_decoder_t;
+
+
+/**
+ * Setup stream encoder
+ * dt_us           Frame duration in us, 7500 or 10000
+ * sr_hz           Samplerate in Hz, 8000, 16000, 24000, 32000, 44100 or 48000
+ * sr_pcm_hz       Input samplerate, downsampling option of input, or 0
+ * nch             Number of channels, 1 or more
+ * bitrate         Bitrate of the stream, shared by the channels
+ * fmt             PCM input format
+ * return          Encoder as an handle, NULL on bad parameters or
+ *                 when the allocation failed
+ */
+lc3_stream_encoder_t lc3_stream_setup_encoder(int dt_us, int sr_hz,
+    int sr_pcm_hz, int nch, int bitrate, enum lc3_pcm_format fmt);
+
+/**
+ * Free stream encoder
+ * encoder         Handle of the encoder, NULL is ignored
+ */
+void lc3_stream_free_encoder(lc3_stream_encoder_t encoder);
+
+/**
+ * Write the header of the LC3 binary format
+ * encoder         Handle of the encoder
+ * nsamples        Number of input samples by channel, 0 when unknown
+ * out             Output buffer of `LC3_HDR_SIZ` bytes
+ * return          Size of the header in bytes, -1 on wrong parameters
+ */
+int lc3_stream_encoder_header(
+    lc3_stream_encoder_t encoder, int nsamples, void *out);
+
+/**
+ * Return the size of the slots of the records
+ * encoder         Handle of the encoder
+ * return          Size in bytes of a record, -1 on wrong parameters
+ */
+int lc3_stream_encoder_slot_size(lc3_stream_encoder_t encoder);
+
+/**
+ * Encode a chunk of PCM samples
+ * encoder         Handle of the encoder
+ * pcm, size       Input PCM samples, channels interleaved, and size in bytes
+ * consumed        Return the number of bytes of `pcm` consumed
+ * slots, nslots   Output slots of `lc3_stream_encoder_slot_size()` bytes,
+ *                 contiguous, and count
+ * return          Number of records written, -1 on wrong parameters
+ *
+ * The chunk is consumed up to the end, unless the slots are exhausted.
+ * In this case, the call is renewed with the remaining of the chunk.
+ * A chunk can end in the middle of a sample; the input `pcm` may be
+ * unaligned, the samples are then gone through the internal buffer.
+ */
+int lc3_stream_encode(lc3_stream_encoder_t encoder,
+    const void *pcm, int size, int *consumed, void *slots, int nslots);
+
+/**
+ * Flush the end of the stream
+ * encoder         Handle of the encoder
+ * slots, nslots   Output slots of `lc3_stream_encoder_slot_size()` bytes,
+ *                 contiguous, and count
+ * return          Number of records written, -1 on wrong parameters
+ *
+ * The pending samples, followed by the algorithmic delay of the codec
+ * (see `lc3_delay_samples()`), are completed with silence and encoded.
+ * The call is renewed until it returns 0; the encoder is then ready
+ * to encode a new stream.
+ */
+int lc3_stream_encoder_flush(
+    lc3_stream_encoder_t encoder, void *slots, int nslots);
+
+
+/**
+ * Setup stream decoder
+ * sr_pcm_hz       Output samplerate, resampling option of output, or 0
+ * fmt             PCM output format
+ * return          Decoder as an handle, NULL on bad parameters or
+ *                 when the allocation failed
+ *
+ * The parameters of the stream are read from the header. The states of
+ * the channels are allocated on reception of the header.
+ */
+lc3_stream_decoder_t lc3_stream_setup_decoder(
+    int sr_pcm_hz, enum lc3_pcm_format fmt);
+
+/**
+ * Free stream decoder
+ * decoder         Handle of the decoder, NULL is ignored
+ */
+void lc3_stream_free_decoder(lc3_stream_decoder_t decoder);
+
+/**
+ * Return the parameters of the stream decoded
+ * decoder         Handle of the decoder
+ * dt_us           Return the frame duration in us
+ * sr_pcm_hz       Return the output samplerate in Hz
+ * nch             Return the number of channels
+ * nsamples        Return the number of samples by channel, at the output
+ *                 samplerate, 0 when not known
+ * return          0: On success  -1: The header is not yet received
+ */
+int lc3_stream_decoder_info(lc3_stream_decoder_t decoder,
+    int *dt_us, int *sr_pcm_hz, int *nch, int *nsamples);
+
+/**
+ * Push a chunk of the LC3 binary format
+ * decoder         Handle of the decoder
+ * in, size        Input chunk, and size in bytes
+ * return          Number of bytes consumed, -1 on malformed stream
+ *
+ * The input is consumed until a frame is decoded, and no more while its
+ * samples are pending. A record of size 0 is concealed by PLC.
+ */
+int lc3_stream_decoder_push(
+    lc3_stream_decoder_t decoder, const void *in, int size);
+
+/**
+ * Return the size of the pending output
+ * decoder         Handle of the decoder
+ * return          Number of bytes of PCM samples pending, -1 on
+ *                 wrong parameters
+ *
+ * The samples are interleaved. The algorithmic delay of the codec is
+ * removed, and the output stops at the number of samples of the header.
+ */
+int lc3_stream_decoder_pending(lc3_stream_decoder_t decoder);
+
+/**
+ * Pull the pending output
+ * decoder         Handle of the decoder
+ * pcm, size       Output buffer, and size in bytes
+ * return          Number of bytes written, -1 on wrong parameters
+ */
+int lc3_stream_decoder_pull(
+    lc3_stream_decoder_t decoder, void *pcm, int size);
+
+/**
+ * Signal the end of the input
+ * decoder         Handle of the decoder
+ * return          0: On success  -1: Wrong parameters
+ *
+ * When the stream is shorter than the number of samples announced by the
+ * header, the missing samples are output as silence.
+ */
+int lc3_stream_decoder_end(lc3_stream_decoder_t decoder);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LC3_STREAM_H */
@@ -17,31 +17,20 @@
  ******************************************************************************/
 
 #include "attdet.h"
+#include "attdet_sse.h"
 
 
 /**
- * Time domain attack detector
+ * Filtering and energy calculation of the blocks
+ * sr              Samplerate, 32 or 48 KHz
+ * nblk            Number of blocks of 40 downsampled samples
+ * x               [-6..-1] Previous, [0..ns-1] Current samples
+ * e               Output the energy of the `nblk` blocks
  */
-bool lc3_attdet_run(enum lc3_dt dt, enum lc3_srate sr,
-    int nbytes, struct lc3_attdet_analysis *attdet, const int16_t *x)
+#ifndef filter_energy
+LC3_HOT static void filter_energy(
+    enum lc3_srate sr, int nblk, const int16_t *x, int32_t *e)
 {
-    /* --- Check enabling --- */
-
-    const int nbytes_ranges[LC3_NUM_DT][LC3_NUM_SRATE - LC3_SRATE_32K][2] = {
-            [LC3_DT_7M5] = { { 61,     149 }, {  75,     149 } },
-            [LC3_DT_10M] = { { 81, INT_MAX }, { 100, INT_MAX } },
-    };
-
-    if (sr < LC3_SRATE_32K ||
-            nbytes < nbytes_ranges[dt][sr - LC3_SRATE_32K][0] ||
-            nbytes > nbytes_ranges[dt][sr - LC3_SRATE_32K][1]   )
-        return 0;
-
-    /* --- Filtering & Energy calculation --- */
-
-    int nblk = 4 - (dt == LC3_DT_7M5);
-    int32_t e[4];
-
     for (int i = 0; i < nblk; i++) {
         e[i] = 0;
 
@@ -69,6 +58,34 @@ bool lc3_attdet_run(enum lc3_dt dt, enum lc3_srate sr,
             }
         }
     }
+}
+#endif /* filter_energy */
+
+
+/**
+ * Time domain attack detector
+ */
+bool lc3_attdet_run(enum lc3_dt dt, enum lc3_srate sr,
+    int nbytes, struct lc3_attdet_analysis *attdet, const int16_t *x)
+{
+    /* --- Check enabling --- */
+
+    const int nbytes_ranges[LC3_NUM_DT][LC3_NUM_SRATE - LC3_SRATE_32K][2] = {
+            [LC3_DT_7M5] = { { 61,     149 }, {  75,     149 } },
+            [LC3_DT_10M] = { { 81, INT_MAX }, { 100, INT_MAX } },
+    };
+
+    if (sr < LC3_SRATE_32K ||
+            nbytes < nbytes_ranges[dt][sr - LC3_SRATE_32K][0] ||
+            nbytes > nbytes_ranges[dt][sr - LC3_SRATE_32K][1]   )
+        return 0;
+
+    /* --- Filtering & Energy calculation --- */
+
+    int nblk = 4 - (dt == LC3_DT_7M5);
+    int32_t e[4];
+
+    filter_energy(sr, nblk, x, e);
 
     /* --- Attack detection ---
      * The attack block `p_att` is defined as the normative value + 1,
@@ -0,0 +1,222 @@
+/******************************************************************************
+ *
+ *  Copyright 2022 Google LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "cpu.h"
+#include "mdct.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+
+/* ----------------------------------------------------------------------------
+ *  Operations tables
+ * -------------------------------------------------------------------------- */
+
+/**
+ * Declare the entry points of a level, and its operations table
+ */
+#define LC3_CPU_LEVEL_DECLARE(level) \
+    \
+    bool lc3_attdet_run_ ## level(enum lc3_dt, enum lc3_srate, \
+        int, lc3_attdet_analysis_t *, const int16_t *); \
+    \
+    void lc3_mdct_forward_ ## level(enum lc3_dt, enum lc3_srate, \
+        enum lc3_srate, const float *, float *, float *); \
+    \
+    void lc3_mdct_inverse_ ## level(enum lc3_dt, enum lc3_srate, \
+        enum lc3_srate, const float *, float *, float *); \
+    \
+    bool lc3_ltpf_analyse_ ## level(enum lc3_dt, enum lc3_srate, bool, \
+        lc3_ltpf_analysis_t *, const int16_t *, lc3_ltpf_data_t *); \
+    \
+    void lc3_ltpf_synthesize_ ## level(enum lc3_dt, enum lc3_srate, int, \
+        lc3_ltpf_synthesis_t *, const lc3_ltpf_data_t *, \
+        const float *, float *); \
+    \
+    void lc3_sns_analyze_ ## level(enum lc3_dt, enum lc3_srate, \
+        const float *, bool, lc3_sns_data_t *, const float *, float *); \
+    \
+    void lc3_tns_analyze_ ## level(enum lc3_dt, enum lc3_bandwidth, \
+        bool, int, lc3_tns_data_t *, float *); \
+    \
+    void lc3_tns_synthesize_ ## level(enum lc3_dt, enum lc3_bandwidth, \
+        const lc3_tns_data_t *, float *); \
+    \
+    void lc3_spec_analyze_ ## level(enum lc3_dt, enum lc3_srate, \
+        int, bool, const lc3_tns_data_t *, bool, \
+        lc3_spec_analysis_t *, float *, uint16_t *, lc3_spec_side_t *); \
+    \
+    static const struct lc3_cpu_ops ops_ ## level = { \
+        .attdet_run      = lc3_attdet_run_ ## level,      \
+        .mdct_forward    = lc3_mdct_forward_ ## level,    \
+        .mdct_inverse    = lc3_mdct_inverse_ ## level,    \
+        .ltpf_analyse    = lc3_ltpf_analyse_ ## level,    \
+        .ltpf_synthesize = lc3_ltpf_synthesize_ ## level, \
+        .sns_analyze     = lc3_sns_analyze_ ## level,     \
+        .tns_analyze     = lc3_tns_analyze_ ## level,     \
+        .tns_synthesize  = lc3_tns_synthesize_ ## level,  \
+        .spec_analyze    = lc3_spec_analyze_ ## level,    \
+    }
+
+static const struct lc3_cpu_ops ops_generic = {
+    .attdet_run      = lc3_attdet_run,
+    .mdct_forward    = lc3_mdct_forward,
+    .mdct_inverse    = lc3_mdct_inverse,
+    .ltpf_analyse    = lc3_ltpf_analyse,
+    .ltpf_synthesize = lc3_ltpf_synthesize,
+    .sns_analyze     = lc3_sns_analyze,
+    .tns_analyze     = lc3_tns_analyze,
+    .tns_synthesize  = lc3_tns_synthesize,
+    .spec_analyze    = lc3_spec_analyze,
+};
+
+#if defined(__x86_64__) || defined(__i386__)
+
+LC3_CPU_LEVEL_DECLARE(sse4);
+LC3_CPU_LEVEL_DECLARE(avx2);
+
+static const struct lc3_cpu_ops *ops_table[LC3_NUM_CPU_LEVEL] = {
+    [LC3_CPU_GENERIC] = &ops_generic,
+    [LC3_CPU_SSE4   ] = &ops_sse4,
+    [LC3_CPU_AVX2   ] = &ops_avx2,
+};
+
+#else /* __x86_64__ || __i386__ */
+
+static const struct lc3_cpu_ops *ops_table[LC3_NUM_CPU_LEVEL] = {
+    [LC3_CPU_GENERIC] = &ops_generic,
+};
+
+#endif /* __x86_64__ || __i386__ */
+
+
+/* ----------------------------------------------------------------------------
+ *  Level selection
+ * -------------------------------------------------------------------------- */
+
+/**
+ * Level forced by `lc3_set_cpu_level()`, -1 when not forced
+ */
+static atomic_int forced_level = -1;
+
+/**
+ * Levels resolved once, the highest supported by the processor,
+ * and the one in use when not forced, with its operations
+ */
+static pthread_once_t probe_once = PTHREAD_ONCE_INIT;
+
+static enum lc3_cpu_level max_level, auto_level;
+static const struct lc3_cpu_ops *auto_ops;
+
+/**
+ * Return the highest level supported by the processor
+ */
+static enum lc3_cpu_level probe_level(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return LC3_CPU_AVX2;
+
+    if (__builtin_cpu_supports("sse4.1"))
+        return LC3_CPU_SSE4;
+
+#endif /* __x86_64__ || __i386__ */
+
+    return LC3_CPU_GENERIC;
+}
+
+/**
+ * Return the level given by the environment variable `LC3_CPU`
+ * return          The level, -1 when not set or unknown
+ */
+static int env_level(void)
+{
+    static const char *names[LC3_NUM_CPU_LEVEL] = {
+        [LC3_CPU_GENERIC] = "generic",
+        [LC3_CPU_SSE4   ] = "sse4",
+        [LC3_CPU_AVX2   ] = "avx2",
+    };
+
+    const char *env = getenv("LC3_CPU");
+    if (!env)
+        return -1;
+
+    for (int level = 0; level < LC3_NUM_CPU_LEVEL; level++)
+        if (strcmp(env, names[level]) == 0)
+            return level;
+
+    return -1;
+}
+
+/**
+ * Probe the processor, and read the environment, once by process
+ */
+static void probe(void)
+{
+    int level = env_level();
+
+    max_level = probe_level();
+    if (level < 0 || level > (int)max_level || !ops_table[level])
+        level = max_level;
+
+    auto_level = level;
+    auto_ops = ops_table[level];
+}
+
+/**
+ * Force the processor level
+ */
+int lc3_set_cpu_level(int level)
+{
+    pthread_once(&probe_once, probe);
+
+    if (level >= LC3_NUM_CPU_LEVEL)
+        return -1;
+
+    if (level >= 0 && (level > (int)max_level || !ops_table[level]))
+        return -1;
+
+    atomic_store(&forced_level, level < 0 ? -1 : level);
+    return 0;
+}
+
+/**
+ * Return the processor level in use
+ */
+enum lc3_cpu_level lc3_get_cpu_level(void)
+{
+    pthread_once(&probe_once, probe);
+
+    int level = atomic_load(&forced_level);
+    return level >= 0 ? (enum lc3_cpu_level)level : auto_level;
+}
+
+/**
+ * Return the operations of the processor level in use
+ */
+const struct lc3_cpu_ops *lc3_cpu_ops(void)
+{
+    pthread_once(&probe_once, probe);
+
+    int level = atomic_load(&forced_level);
+    return level >= 0 ? ops_table[level] : auto_ops;
+}
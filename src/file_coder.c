@@ -1,3 +1,5 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <lc3.h>
 #include <lc3_iface.h>
 #include <lc3_header.h>
@@ -7,8 +9,14 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 #include "wave.h"
 #include "lc3bin.h"
+#include "resample.h"
 #include "log.h"
 
 
@@ -19,10 +27,129 @@ void file_close(FILE * const f){
     }
 }
 
+
+/* --- Memory-mapped files --- */
+
+typedef struct {
+    int fd;
+    uint8_t * p;
+    uint32_t siz;
+} file_map_t;
+
+/**
+ * map the whole regular file 'fname' for a sequential read
+ * 
+ * @return 0 on success, -1 when the file can't be mapped
+*/
+static
+int file_map_in(const char * const fname, file_map_t * const m)
+{
+    m->fd = open(fname, O_RDONLY);
+    if(0 > m->fd){
+        return -1;
+    }
+
+    struct stat st;
+    if(0 != fstat(m->fd, &st) || !S_ISREG(st.st_mode) ||
+       0 == st.st_size || UINT32_MAX < (uint64_t)st.st_size){
+        close(m->fd);
+        return -1;
+    }
+
+    m->siz = st.st_size;
+    m->p = mmap(NULL, m->siz, PROT_READ, MAP_PRIVATE, m->fd, 0);
+    if(MAP_FAILED == m->p){
+        close(m->fd);
+        return -1;
+    }
+
+    posix_madvise(m->p, m->siz, POSIX_MADV_SEQUENTIAL);
+    return 0;
+}
+
+/**
+ * create 'fname' of 'siz' bytes and map it for a sequential write
+ * 
+ * @return 0 on success, -1 when the file can't be mapped
+*/
+static
+int file_map_out(const char * const fname, const uint32_t siz, file_map_t * const m)
+{
+    m->fd = open(fname, O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if(0 > m->fd){
+        return -1;
+    }
+
+    struct stat st;
+    if(0 != fstat(m->fd, &st) || !S_ISREG(st.st_mode) ||
+       0 != ftruncate(m->fd, siz)){
+        close(m->fd);
+        return -1;
+    }
+
+    m->siz = siz;
+    m->p = mmap(NULL, m->siz, PROT_READ | PROT_WRITE, MAP_SHARED, m->fd, 0);
+    if(MAP_FAILED == m->p){
+        close(m->fd);
+        return -1;
+    }
+
+    posix_madvise(m->p, m->siz, POSIX_MADV_SEQUENTIAL);
+    return 0;
+}
+
+static
+void file_unmap(file_map_t * const m)
+{
+    munmap(m->p, m->siz);
+    close(m->fd);
+}
+
+/**
+ * convert between mapped files with the stream coder, the output is
+ * preallocated with the exact size announced by the input header
+ * 
+ * @return error codes, or 1 when the files can't be mapped, and the
+ *         conversion is left to the stdio path
+*/
+static
+int file_map_convert(ilc3_coder_t * const coder,
+                     const char * const fin,
+                     const char * const fout,
+                     const bool to_lc3)
+{
+    if(NULL == fin || NULL == fout){
+        return 1;
+    }
+
+    file_map_t in, out;
+    if(0 != file_map_in(fin, &in)){
+        return 1;
+    }
+
+    const ilc3_res_t out_siz = to_lc3 ?
+        lc3_stream_encoded_size(coder, in.p, in.siz, true) :
+        lc3_stream_decoded_size(coder, in.p, in.siz);
+    if(ILC3_OK >= out_siz || 0 != file_map_out(fout, out_siz, &out)){
+        file_unmap(&in);
+        return 1;
+    }
+
+    const ilc3_res_t res = to_lc3 ?
+        stream_to_lc3(coder, in.p, in.siz, out.p, out.siz, true) :
+        lc3_to_stream(coder, in.p, in.siz, out.p, out.siz);
+
+    file_unmap(&in);
+    file_unmap(&out);
+
+    /* on a short input, the stdio path completes it with silence */
+    return (out_siz == res)? ILC3_OK : 1;
+}
+
 ilc3_res_t lc3_coder_init(ilc3_coder_t * const enc,
                    uint32_t bitrate,
                    uint32_t samplesiz,
-                   uint16_t srate_hz,
+                   uint32_t srate_hz,
                    uint8_t nch,
                    float frame_us)
 {
@@ -31,6 +158,7 @@ ilc3_res_t lc3_coder_init(ilc3_coder_t * const enc,
     enc->srate_hz = srate_hz;
     enc->nch = nch;
     enc->frame_us = frame_us;
+    enc->pool = NULL;
 
     return ILC3_OK;
 }
@@ -49,6 +177,11 @@ ilc3_res_t file_wav_to_lc3(const ilc3_coder_t * const encoder,
                            const char * const fin,
                            const char * const fout)
 {
+    ilc3_coder_t coder = *encoder;
+    if(ILC3_OK == file_map_convert(&coder, fin, fout, true)){
+        return ILC3_OK;
+    }
+
     FILE* fp_in = (NULL == fin)? stdin : fopen(fin, "rb");
     if(NULL == fp_in){
         ERROR("can't open %s\n", fin);
@@ -90,17 +223,34 @@ ilc3_res_t file_wav_to_lc3(const ilc3_coder_t * const encoder,
     }
 
 
+    if (!ILC3_CHECK_SR_HZ(srate_hz)){
+        ERROR("bad srate_hz\n");
+        file_close(fp_in);
+        return ILC3_BAD_ARG;
+    }
+
     int enc_srate_hz = 0;
     int enc_samples = 0;
     const int encoder_srate = encoder->srate_hz;
-    if(0 == encoder_srate){
-        enc_srate_hz = srate_hz;
-        enc_samples = nsamples;
+    if(0 == encoder_srate || !LC3_CHECK_SR_HZ(encoder_srate)){
+        enc_srate_hz = resample_lc3_hz(srate_hz);
     } else {
         enc_srate_hz = encoder_srate;
+    }
+
+    /* samplerates the encoder can't downsample itself are resampled to the
+     * samplerate of the encoder, or by default to the closest higher LC3 one */
+    const bool resample = !resample_lc3_native(enc_srate_hz, srate_hz) ||
+                          enc_srate_hz > srate_hz;
+    if(enc_srate_hz == srate_hz){
+        enc_samples = nsamples;
+    } else {
         enc_samples = ((int64_t)nsamples * enc_srate_hz) / srate_hz;
     }
 
+    const int pcm_srate_hz = resample ? enc_srate_hz : srate_hz;
+    const int pcm_samples = resample ? enc_samples : nsamples;
+
     FILE * fp_out = (NULL == fout)? stdout : fopen(fout, "wb");
     if(NULL == fp_out){
         ERROR("can't open %s\n", fout);
@@ -129,68 +279,101 @@ ilc3_res_t file_wav_to_lc3(const ilc3_coder_t * const encoder,
     uint8_t out[2 * LC3_MAX_FRAME_BYTES];
     lc3_encoder_t enc[2];
 
-    const int frame_bytes = lc3_frame_bytes(frame_us, bitrate / nch);
-    const int frame_samples = lc3_frame_samples(frame_us, srate_hz);
-    const int encode_samples = nsamples + lc3_delay_samples(frame_us, srate_hz);
+    const int frame_bytes = lc3_frame_bytes_ex(frame_us, enc_srate_hz, bitrate / nch);
+    const int frame_samples = lc3_frame_samples(frame_us, pcm_srate_hz);
+    const int encode_samples = pcm_samples + lc3_delay_samples(frame_us, pcm_srate_hz);
     const enum lc3_pcm_format pcm_fmt =
         pcm_sbytes == 32/8 ? LC3_PCM_FORMAT_S24 :
         pcm_sbytes == 24/8 ? LC3_PCM_FORMAT_S24_3LE : LC3_PCM_FORMAT_S16;
 
-    const uint32_t encoder_size = lc3_encoder_size(frame_us, srate_hz);
+    /* the resampled frames are read in the buffer of the resampler,
+     * and given to the encoder as float samples */
+    resample_coder_t rc = { 0 };
+    if(resample){
+        const int frame_in = ((int64_t)frame_samples * srate_hz) / pcm_srate_hz + 1;
+        if(0 != resample_coder_init(&rc, srate_hz, pcm_srate_hz, nch, pcm_fmt, frame_in)){
+            ERROR("can't init resampler\n");
+            file_close(fp_in);
+            file_close(fp_out);
+            return ILC3_BAD_ARG;
+        }
+    }
+
+    const uint32_t encoder_size = lc3_encoder_size(frame_us, pcm_srate_hz);
     for (int ich = 0; ich < nch; ich++){
         enc[ich] = lc3_setup_encoder(frame_us,
                                      enc_srate_hz,
-                                     srate_hz,
-                                     malloc(encoder_size));
+                                     pcm_srate_hz,
+                                     lc3_pool_get(encoder->pool,
+                                                  encoder_size));
     }
 
     
     /* --- Encoding loop --- */
 
-    for (int i = 0; i * frame_samples < encode_samples; i++) {
-        int nread = fread(pcm, nch * pcm_sbytes, frame_samples, fp_in);
+    ilc3_res_t res = ILC3_OK;
+
+    for (int ich = 0; ich < nch; ich++){
+        if(NULL == enc[ich]){
+            ERROR("can't setup encoder\n");
+            res = ILC3_BAD_ARG;
+        }
+    }
+
+    for (int i = 0; ILC3_OK == res && i * frame_samples < encode_samples; i++) {
+        const int nin = resample ?
+            resampler_needed(&rc.rs, frame_samples) : frame_samples;
+        int8_t * const in = resample ? rc.pcm : pcm;
+
+        int nread = fread(in, nch * pcm_sbytes, nin, fp_in);
         if(0 > nread){
             ERROR("in file not enought data\n");
-            for (int ich = 0; ich < nch; ich++){
-                free(enc[ich]);
-            }
-
-            file_close(fp_in);
-            file_close(fp_out);
-            return ILC3_BAD_INOUT;
+            res = ILC3_BAD_INOUT;
+            break;
         }
 
-        memset(pcm + nread * nch * pcm_sbytes, 0,
-            nch * (frame_samples - nread) * pcm_sbytes);
+        memset(in + nread * nch * pcm_sbytes, 0,
+            nch * (nin - nread) * pcm_sbytes);
+
+        const float * const rs_out = resample ?
+            resample_coder_from_pcm(&rc, nin, frame_samples) : NULL;
 
         for (int ich = 0; ich < nch; ich++){
-            lc3_encode(enc[ich],
-                       pcm_fmt,
-                       pcm + ich * pcm_sbytes, nch,
-                       frame_bytes,
-                       out + ich * frame_bytes);
+            if(resample){
+                lc3_encode(enc[ich],
+                           LC3_PCM_FORMAT_FLOAT,
+                           rs_out + ich, nch,
+                           frame_bytes,
+                           out + ich * frame_bytes);
+            } else {
+                lc3_encode(enc[ich],
+                           pcm_fmt,
+                           pcm + ich * pcm_sbytes, nch,
+                           frame_bytes,
+                           out + ich * frame_bytes);
+            }
         }
 
         const int wres = lc3bin_fwrite_data(fp_out, out, nch, frame_bytes);
         if(0 != wres){
             ERROR("can't write lc3 frame to file\n");
-            for (int ich = 0; ich < nch; ich++){
-                free(enc[ich]);
-            }
-            return ILC3_BAD_INOUT;
+            res = ILC3_BAD_INOUT;
+            break;
         }
     }
 
     /* --- Cleanup --- */
 
     for (int ich = 0; ich < nch; ich++){
-        free(enc[ich]);
+        lc3_pool_put(encoder->pool, enc[ich]);
     }
 
+    resample_coder_free(&rc);
+
     file_close(fp_in);
     file_close(fp_out);
 
-    return ILC3_OK;
+    return res;
 }
 
 /**
@@ -201,6 +384,10 @@ ilc3_res_t file_lc3_to_wav(ilc3_coder_t * const decoder,
                            const char * const fin,
                            const char * const fout)
 {
+    if(ILC3_OK == file_map_convert(decoder, fin, fout, false)){
+        return ILC3_OK;
+    }
+
     FILE* fp_in = (NULL == fin)? stdin : fopen(fin, "rb");
     if(NULL == fp_in){
         ERROR("can't open %s\n", fin);
@@ -228,7 +415,7 @@ ilc3_res_t file_lc3_to_wav(ilc3_coder_t * const decoder,
     }
 
     const int dstate_hz = decoder->srate_hz;
-    if (!LC3_CHECK_SR_HZ(srate_hz) || (dstate_hz && dstate_hz < srate_hz)){
+    if (!LC3_CHECK_SR_HZ(srate_hz) || (dstate_hz && !ILC3_CHECK_SR_HZ(dstate_hz))){
         ERROR("bad srate_hz\n");
         file_close(fp_in);
         return ILC3_BAD_ARG;
@@ -241,6 +428,11 @@ ilc3_res_t file_lc3_to_wav(ilc3_coder_t * const decoder,
     int pcm_samples = !dstate_hz ? nsamples :
         ((int64_t)nsamples * pcm_srate_hz) / srate_hz;
 
+    /* samplerates the decoder can't give itself are resampled from the
+     * closest higher LC3 samplerate, the stream one when lower */
+    const int dec_srate_hz = resample_dec_hz(srate_hz, pcm_srate_hz);
+    const bool resample = dec_srate_hz != pcm_srate_hz;
+
     FILE * fp_out = (NULL == fout)? stdout : fopen(fout, "wb");
     if(NULL == fp_out){
         ERROR("can't open %s\n", fout);
@@ -270,43 +462,98 @@ ilc3_res_t file_lc3_to_wav(ilc3_coder_t * const decoder,
     int8_t alignas(int32_t) pcm[2 * LC3_MAX_FRAME_SAMPLES*4];
     lc3_decoder_t dec[2];
 
-    int frame_samples = lc3_frame_samples(frame_us, pcm_srate_hz);
+    int frame_samples = lc3_frame_samples(frame_us, dec_srate_hz);
     int encode_samples = pcm_samples +
         lc3_delay_samples(frame_us, pcm_srate_hz);
     enum lc3_pcm_format pcm_fmt =
         pcm_sbits == 24 ? LC3_PCM_FORMAT_S24_3LE : LC3_PCM_FORMAT_S16;
 
-    for (int ich = 0; ich < nch; ich++)
-        dec[ich] = lc3_setup_decoder(frame_us, srate_hz, dstate_hz,
-            malloc(lc3_decoder_size(frame_us, pcm_srate_hz)));
+    bool dec_ok = true;
+    for (int ich = 0; ich < nch; ich++){
+        dec[ich] = lc3_setup_decoder(frame_us, srate_hz, dec_srate_hz,
+            lc3_pool_get(decoder->pool, lc3_decoder_size(frame_us,
+                srate_hz > dec_srate_hz ? srate_hz : dec_srate_hz)));
+        dec_ok = dec_ok && NULL != dec[ich];
+    }
+
+    if (!dec_ok){
+        ERROR("can't setup decoder\n");
+        for (int ich = 0; ich < nch; ich++)
+            lc3_pool_put(decoder->pool, dec[ich]);
+        file_close(fp_in);
+        file_close(fp_out);
+        return ILC3_BAD_ARG;
+    }
+
+    /* the frames to resample are decoded as float samples */
+    resample_coder_t rc = { 0 };
+    if (resample){
+        if (0 != resample_coder_init(&rc, dec_srate_hz, pcm_srate_hz, nch, pcm_fmt, frame_samples)){
+            ERROR("can't init resampler\n");
+            for (int ich = 0; ich < nch; ich++)
+                lc3_pool_put(decoder->pool, dec[ich]);
+            file_close(fp_in);
+            file_close(fp_out);
+            return ILC3_BAD_ARG;
+        }
+    }
 
     /* --- Decoding loop --- */
 
-    for (int i = 0; i * frame_samples < encode_samples; i++) {
+    int nwritten = 0;
+    ilc3_res_t res = ILC3_OK;
+
+    for (int i = 0; resample ? nwritten < pcm_samples :
+                               i * frame_samples < encode_samples; i++) {
+        enum lc3_pcm_format dec_fmt = resample ? LC3_PCM_FORMAT_FLOAT : pcm_fmt;
+        int dec_sbytes = resample ? (int)sizeof(float) : pcm_sbytes;
+
         int frame_bytes = lc3bin_fread_data(fp_in, nch, in);
         if (frame_bytes <= 0)
-            memset(pcm, 0, nch * frame_samples * pcm_sbytes);
+            memset(pcm, 0, nch * frame_samples * dec_sbytes);
         else
             for (int ich = 0; ich < nch; ich++)
                 lc3_decode(dec[ich],
                     in + ich * frame_bytes, frame_bytes,
-                    pcm_fmt, pcm + ich * pcm_sbytes, nch);
+                    dec_fmt, pcm + ich * dec_sbytes, nch);
+
+        const int8_t * out = NULL;
+        int pcm_nwrite = 0;
+
+        if (resample) {
+            int offset = i > 0 ? 0 : lc3_delay_samples(frame_us, dec_srate_hz);
+            pcm_nwrite = resample_coder_to_pcm(&rc,
+                (const float *)pcm + nch * offset, frame_samples - offset,
+                pcm_samples - nwritten);
+            out = rc.pcm;
+        } else {
+            int pcm_offset = i > 0 ? 0 : encode_samples - pcm_samples;
+            pcm_nwrite = MIN(frame_samples - pcm_offset,
+                encode_samples - i*frame_samples);
+            out = pcm + nch * pcm_offset * pcm_sbytes;
+        }
 
-        int pcm_offset = i > 0 ? 0 : encode_samples - pcm_samples;
-        int pcm_nwrite = MIN(frame_samples - pcm_offset,
-            encode_samples - i*frame_samples);
+        nwritten += pcm_nwrite;
+        if (0 >= pcm_nwrite)
+            continue;
 
-        fwrite(pcm + nch * pcm_offset * pcm_sbytes, nch * pcm_sbytes, pcm_nwrite, fp_out);
+        if ((size_t)pcm_nwrite !=
+                fwrite(out, nch * pcm_sbytes, pcm_nwrite, fp_out)){
+            ERROR("can't write pcm to file\n");
+            res = ILC3_BAD_INOUT;
+            break;
+        }
     }
 
     /* --- Cleanup --- */
 
     for (int ich = 0; ich < nch; ich++){
-        free(dec[ich]);
+        lc3_pool_put(decoder->pool, dec[ich]);
     }
 
+    resample_coder_free(&rc);
+
     file_close(fp_in);
     file_close(fp_out);
-    return ILC3_OK;
+    return res;
 }
-
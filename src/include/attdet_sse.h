@@ -0,0 +1,113 @@
+/******************************************************************************
+ *
+ *  Copyright 2022 Google LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#if defined(__SSE4_1__) && !defined(TEST_NEON) || defined(TEST_SSE)
+
+#include <immintrin.h>
+
+
+/**
+ * Filtering and energy calculation of the blocks
+ *
+ * The downsampled signal is first computed on 32 bits, 4 samples by
+ * vector, then filtered. For 48 KHz, the triplets of samples are
+ * gathered as a pair, summed by `pmaddwd`, and a single sample.
+ */
+#ifndef filter_energy
+
+LC3_HOT static void sse_filter_energy(
+    enum lc3_srate sr, int nblk, const int16_t *x, int32_t *e)
+{
+    int32_t u[2 + 4*40], *xn = u + 2;
+    int n = 40 * nblk;
+
+    const __m128i ones = _mm_set1_epi16(1);
+
+    /* --- Downsampling --- */
+
+    if (sr == LC3_SRATE_32K) {
+        xn[-2] = (x[-4] + x[-3]) >> 1;
+        xn[-1] = (x[-2] + x[-1]) >> 1;
+
+        for (int j = 0; j < n; j += 4) {
+            __m128i x0 = _mm_loadu_si128((const __m128i *)(x + 2*j));
+
+            _mm_storeu_si128((__m128i *)(xn + j),
+                _mm_srai_epi32(_mm_madd_epi16(x0, ones), 1));
+        }
+    }
+
+    else {
+        const __m128i p0 = _mm_setr_epi8(
+             0,  1,  2,  3,  6,  7,  8,  9, 12, 13, 14, 15, -1, -1, -1, -1);
+        const __m128i p1 = _mm_setr_epi8(
+            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 10, 11, 12, 13);
+        const __m128i q0 = _mm_setr_epi8(
+            -1, -1,  4,  5, -1, -1, 10, 11, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i q1 = _mm_setr_epi8(
+            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  8,  9, -1, -1, 14, 15);
+
+        xn[-2] = (x[-6] + x[-5] + x[-4]) >> 2;
+        xn[-1] = (x[-3] + x[-2] + x[-1]) >> 2;
+
+        for (int j = 0; j < n; j += 4) {
+            __m128i x0 = _mm_loadu_si128((const __m128i *)(x + 3*j    ));
+            __m128i x1 = _mm_loadu_si128((const __m128i *)(x + 3*j + 4));
+
+            __m128i xp = _mm_or_si128(
+                _mm_shuffle_epi8(x0, p0), _mm_shuffle_epi8(x1, p1));
+            __m128i xq = _mm_or_si128(
+                _mm_shuffle_epi8(x0, q0), _mm_shuffle_epi8(x1, q1));
+
+            __m128i s = _mm_add_epi32(
+                _mm_madd_epi16(xp, ones), _mm_srai_epi32(xq, 16));
+
+            _mm_storeu_si128((__m128i *)(xn + j), _mm_srai_epi32(s, 2));
+        }
+    }
+
+    /* --- Filtering & Energy --- */
+
+    for (int i = 0; i < nblk; i++, xn += 40) {
+        __m128i ei = _mm_setzero_si128();
+
+        for (int j = 0; j < 40; j += 4) {
+            __m128i x0 = _mm_loadu_si128((const __m128i *)(xn + j    ));
+            __m128i x1 = _mm_loadu_si128((const __m128i *)(xn + j - 1));
+            __m128i x2 = _mm_loadu_si128((const __m128i *)(xn + j - 2));
+
+            __m128i xf = _mm_add_epi32(x0, _mm_slli_epi32(x0, 1));
+            xf = _mm_sub_epi32(xf, _mm_slli_epi32(x1, 2));
+            xf = _mm_srai_epi32(_mm_add_epi32(xf, x2), 3);
+
+            ei = _mm_add_epi32(ei, _mm_srai_epi32(_mm_mullo_epi32(xf, xf), 5));
+        }
+
+        ei = _mm_add_epi32(ei, _mm_shuffle_epi32(ei, _MM_SHUFFLE(1, 0, 3, 2)));
+        ei = _mm_add_epi32(ei, _mm_shuffle_epi32(ei, _MM_SHUFFLE(2, 3, 0, 1)));
+        e[i] = _mm_cvtsi128_si32(ei);
+    }
+}
+
+#ifndef TEST_SSE
+#define filter_energy sse_filter_energy
+#endif
+
+#endif /* filter_energy */
+
+#endif /* __SSE4_1__ */
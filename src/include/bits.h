@@ -306,6 +306,21 @@ LC3_HOT static inline unsigned lc3_get_symbol(
     ac->low -= range * symbols[s].low;
     ac->range = range * symbols[s].range;
 
+    /* --- Renormalization ---
+     * A symbol consumes less than a byte most of the time, the first
+     * byte is shifted in without branching, on the bits of the range.
+     * The loop is kept for the very unlikely symbols of 2 bytes. */
+
+    struct lc3_bits_buffer *buffer = &bits->buffer;
+
+    int avail = buffer->p_fw < buffer->end;
+    int shift = ac->range < 0x10000 ? 8 : 0;
+    unsigned v = avail ? *buffer->p_fw : 0;
+
+    ac->low = ((ac->low << shift) | (v & (0xff >> (8 - shift)))) & 0xffffff;
+    ac->range <<= shift;
+    buffer->p_fw += avail && shift;
+
     if (ac->range < 0x10000)
         lc3_ac_read_renorm(bits);
 
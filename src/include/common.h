@@ -98,6 +98,7 @@
  * encoded spectrum coefficients within a frame
  * - For encoding, keep 1.25 ms for temporal window
  * - For decoding, keep 18 ms of history, aligned on frames, and a frame
+ * - For compact decoding, keep only the 18 ms of history
  */
 
 #define LC3_NS(dt, sr) \
@@ -122,6 +123,12 @@
 #define LC3_NH(dt, sr) \
     ( ((3 - dt) + 1) * LC3_NS(dt, sr) )
 
+#define LC3_NL(sr) \
+    ( 18 * LC3_SRATE_KHZ(sr) )
+
+#define LC3_MAX_NH \
+    LC3_NH(LC3_DT_10M, LC3_SRATE_48K)
+
 
 /**
  * Bandwidth, mapped to Nyquist frequency of samplerates
@@ -0,0 +1,89 @@
+/******************************************************************************
+ *
+ *  Copyright 2022 Google LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/**
+ * LC3 - Runtime selection of the DSP kernels
+ *
+ * The attack detector, MDCT, LTPF, SNS, TNS and spectrum quantization
+ * modules are built once for each processor level (see `src/makefile.mk`).
+ * The entry points of a level are bound by an operations table,
+ * resolved at setup of the encoders and decoders.
+ */
+
+#ifndef __LC3_CPU_H
+#define __LC3_CPU_H
+
+#include "common.h"
+#include "attdet.h"
+#include "ltpf.h"
+#include "sns.h"
+#include "tns.h"
+#include "spec.h"
+
+
+/**
+ * Operations bound to a processor level
+ */
+
+struct lc3_cpu_ops {
+
+    bool (*attdet_run)(enum lc3_dt dt, enum lc3_srate sr,
+        int nbytes, lc3_attdet_analysis_t *attdet, const int16_t *x);
+
+    void (*mdct_forward)(enum lc3_dt dt, enum lc3_srate sr,
+        enum lc3_srate sr_dst, const float *x, float *d, float *y);
+
+    void (*mdct_inverse)(enum lc3_dt dt, enum lc3_srate sr,
+        enum lc3_srate sr_src, const float *x, float *d, float *y);
+
+    bool (*ltpf_analyse)(enum lc3_dt dt, enum lc3_srate sr, bool track,
+        lc3_ltpf_analysis_t *ltpf, const int16_t *x, lc3_ltpf_data_t *data);
+
+    void (*ltpf_synthesize)(enum lc3_dt dt, enum lc3_srate sr, int nbytes,
+        lc3_ltpf_synthesis_t *ltpf, const lc3_ltpf_data_t *data,
+        const float *xr, float *x);
+
+    void (*sns_analyze)(enum lc3_dt dt, enum lc3_srate sr,
+        const float *eb, bool att, lc3_sns_data_t *data,
+        const float *x, float *y);
+
+    void (*tns_analyze)(enum lc3_dt dt, enum lc3_bandwidth bw,
+        bool nn_flag, int nbytes, lc3_tns_data_t *data, float *x);
+
+    void (*tns_synthesize)(enum lc3_dt dt, enum lc3_bandwidth bw,
+        const lc3_tns_data_t *data, float *x);
+
+    void (*spec_analyze)(enum lc3_dt dt, enum lc3_srate sr,
+        int nbytes, bool pitch, const lc3_tns_data_t *tns, bool adjust,
+        lc3_spec_analysis_t *spec, float *x, uint16_t *xq,
+        lc3_spec_side_t *side);
+};
+
+
+/**
+ * Return the operations of the processor level in use
+ * return          Operations table, never NULL
+ *
+ * The level is the highest supported by the processor, unless forced
+ * by `lc3_set_cpu_level()` or the environment variable `LC3_CPU`.
+ * The processor and the environment are read once, at the first call.
+ */
+const struct lc3_cpu_ops *lc3_cpu_ops(void);
+
+
+#endif /* __LC3_CPU_H */
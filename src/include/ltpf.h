@@ -47,8 +47,8 @@ typedef struct lc3_ltpf_data {
 /**
  * LTPF analysis
  * dt, sr          Duration and samplerate of the frame
+ * track           Track a stable pitch, instead of a complete search
  * ltpf            Context of analysis
- * allowed         True when activation of LTPF is allowed
  * x               [-d..-1] Previous, [0..ns-1] Current samples
  * data            Return bitstream data
  * return          True when pitch present, False otherwise
@@ -57,7 +57,7 @@ typedef struct lc3_ltpf_data {
  * The number of previous samples `d` accessed on `x` is :
  *   d: { 10, 20, 30, 40, 60 } - 1 for samplerates from 8KHz to 48KHz
  */
-bool lc3_ltpf_analyse(enum lc3_dt dt, enum lc3_srate sr,
+bool lc3_ltpf_analyse(enum lc3_dt dt, enum lc3_srate sr, bool track,
     lc3_ltpf_analysis_t *ltpf, const int16_t *x, lc3_ltpf_data_t *data);
 
 /**
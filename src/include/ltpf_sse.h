@@ -0,0 +1,567 @@
+/******************************************************************************
+ *
+ *  Copyright 2022 Google LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#if defined(__SSE4_1__) && !defined(TEST_NEON) || defined(TEST_SSE)
+
+#include <immintrin.h>
+
+
+/**
+ * Import
+ */
+
+static inline int32_t filter_hp50(struct lc3_ltpf_hp50_state *, int32_t);
+
+
+/* ----------------------------------------------------------------------------
+ *  Helpers
+ *
+ *  The products of Q15 samples are accumulated by pairs (`pmaddwd`),
+ *  as the 32 bits arithmetic of the scalar versions.
+ *
+ *  The dot products are accumulated on 64 bits. The sum of a pair lies
+ *  in range [-2^31 + 2^16, 2^31], it's offset by -2^16 to be sign
+ *  extended without overflow, and the offset is compensated at the end.
+ * -------------------------------------------------------------------------- */
+
+/**
+ * Return the sum of the 32 bits, and 64 bits, elements of a vector
+ */
+static inline int32_t sse_hadd_epi32(__m128i v)
+{
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    return _mm_cvtsi128_si32(v);
+}
+
+static inline int64_t sse_hadd_epi64(__m128i v)
+{
+    int64_t r;
+
+    v = _mm_add_epi64(v, _mm_unpackhi_epi64(v, v));
+    _mm_storel_epi64((__m128i *)&r, v);
+
+    return r;
+}
+
+/**
+ * Load the `n` first samples of a vector, `n` being 2, 4 or 6,
+ * the remaining elements are cleared
+ */
+static inline __m128i sse_load_partial(const int16_t *x, int n)
+{
+    __m128i v = n & 4 ?
+        _mm_loadl_epi64((const __m128i *)x) : _mm_setzero_si128();
+
+    if (n & 2) {
+        int32_t u;
+        memcpy(&u, x + (n & 4), sizeof(u));
+        v = n & 4 ? _mm_insert_epi32(v, u, 2) : _mm_cvtsi32_si128(u);
+    }
+
+    return v;
+}
+
+/**
+ * Accumulate the products of 8 (16) samples, on 64 bits,
+ * each sum of pair being offset by -2^16
+ */
+static inline __m128i sse_madd_epi64(__m128i a, __m128i b, __m128i v)
+{
+    __m128i u = _mm_sub_epi32(_mm_madd_epi16(a, b), _mm_set1_epi32(1 << 16));
+
+    v = _mm_add_epi64(v, _mm_cvtepi32_epi64(u));
+    v = _mm_add_epi64(v, _mm_cvtepi32_epi64(_mm_srli_si128(u, 8)));
+
+    return v;
+}
+
+#ifdef __AVX2__
+
+static inline __m256i avx_madd_epi64(__m256i a, __m256i b, __m256i v)
+{
+    __m256i u = _mm256_sub_epi32(
+        _mm256_madd_epi16(a, b), _mm256_set1_epi32(1 << 16));
+
+    v = _mm256_add_epi64(v, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(u)));
+    v = _mm256_add_epi64(v, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(u, 1)));
+
+    return v;
+}
+
+static inline __m128i avx_fold_128(__m256i v)
+{
+    return _mm_add_epi64(
+        _mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+}
+
+#endif /* __AVX2__ */
+
+
+/* ----------------------------------------------------------------------------
+ *  Resampling
+ * -------------------------------------------------------------------------- */
+
+/**
+ * Resample to 12.8 KHz Template
+ * p               Resampling factor with compared to 192 KHz
+ * q               Step of the phases, 5 or 15 for 64 KHz or 192 KHz based
+ * w               Width of the filter
+ * h               Arrange by phase coefficients table, rows of `w`
+ *                 coefficients completed to a multiple of 8 with zeros
+ * hp50            High-Pass biquad filter state
+ * x               [-w+1..-1] Previous, [0..ns-1] Current samples, Q15
+ * y, n            [0..n-1] Output `n` processed samples, Q14
+ */
+#if !defined(resample_8k_12k8) || !defined(resample_16k_12k8) \
+    || !defined(resample_24k_12k8) || !defined(resample_32k_12k8) \
+    || !defined(resample_48k_12k8)
+
+LC3_HOT static inline void sse_resample_12k8(
+    const int p, const int q, const int w, const int16_t *h,
+    struct lc3_ltpf_hp50_state *hp50, const int16_t *x, int16_t *y, int n)
+{
+    const int wp = (w + 7) & ~7;
+
+    x -= w - 1;
+
+    for (int i = 0; i < q*n; i += q) {
+        const int16_t *hn = h + (i % p) * wp;
+        const int16_t *xn = x + (i / p);
+        __m128i un = _mm_setzero_si128();
+        int k = 0;
+
+#ifdef __AVX2__
+
+        /* --- Process by 16 --- */
+
+        if (w >= 16) {
+            __m256i vn = _mm256_setzero_si256();
+
+            for ( ; k + 16 <= w; k += 16)
+                vn = _mm256_add_epi32(vn, _mm256_madd_epi16(
+                    _mm256_loadu_si256((const __m256i *)(xn + k)),
+                    _mm256_loadu_si256((const __m256i *)(hn + k)) ));
+
+            un = _mm_add_epi32(_mm256_castsi256_si128(vn),
+                               _mm256_extracti128_si256(vn, 1));
+        }
+
+#endif /* __AVX2__ */
+
+        /* --- Process by 8 --- */
+
+        for ( ; k + 8 <= w; k += 8)
+            un = _mm_add_epi32(un, _mm_madd_epi16(
+                _mm_loadu_si128((const __m128i *)(xn + k)),
+                _mm_loadu_si128((const __m128i *)(hn + k)) ));
+
+        /* --- Remaining samples, against null coefficients --- */
+
+        if (k < w)
+            un = _mm_add_epi32(un, _mm_madd_epi16(
+                sse_load_partial(xn + k, w - k),
+                _mm_loadu_si128((const __m128i *)(hn + k)) ));
+
+        int32_t yn = filter_hp50(hp50, sse_hadd_epi32(un));
+        *(y++) = (yn + (1 << 15)) >> 16;
+    }
+}
+
+#endif
+
+/**
+ * Resample from 8 Khz to 12.8 KHz
+ */
+#ifndef resample_8k_12k8
+
+LC3_HOT static void sse_resample_8k_12k8(
+    struct lc3_ltpf_hp50_state *hp50, const int16_t *x, int16_t *y, int n)
+{
+    static const int16_t alignas(16) h[8*16] = {
+          214,   417, -1052, -4529, 26233, -4529, -1052,   417,
+          214,     0,     0,     0,     0,     0,     0,     0,
+
+          180,     0, -1522, -2427, 24506, -5289,     0,   763,
+          156,   -28,     0,     0,     0,     0,     0,     0,
+
+           92,  -323, -1361,     0, 19741, -3885,  1317,   861,
+            0,   -61,     0,     0,     0,     0,     0,     0,
+
+            0,  -457,  -752,  1873, 13068,     0,  2389,   598,
+         -213,   -79,     0,     0,     0,     0,     0,     0,
+
+          -61,  -398,     0,  2686,  5997,  5997,  2686,     0,
+         -398,   -61,     0,     0,     0,     0,     0,     0,
+
+          -79,  -213,   598,  2389,     0, 13068,  1873,  -752,
+         -457,     0,     0,     0,     0,     0,     0,     0,
+
+          -61,     0,   861,  1317, -3885, 19741,     0, -1361,
+         -323,    92,     0,     0,     0,     0,     0,     0,
+
+          -28,   156,   763,     0, -5289, 24506, -2427, -1522,
+            0,   180,     0,     0,     0,     0,     0,     0,
+    };
+
+    sse_resample_12k8(8, 5, 10, h, hp50, x, y, n);
+}
+
+#ifndef TEST_SSE
+#define resample_8k_12k8 sse_resample_8k_12k8
+#endif
+
+#endif /* resample_8k_12k8 */
+
+/**
+ * Resample from 16 Khz to 12.8 KHz
+ */
+#ifndef resample_16k_12k8
+
+LC3_HOT static void sse_resample_16k_12k8(
+    struct lc3_ltpf_hp50_state *hp50, const int16_t *x, int16_t *y, int n)
+{
+    static const int16_t alignas(16) h[4*24] = {
+          -61,   214,  -398,   417,     0, -1052,  2686, -4529,
+         5997, 26233,  5997, -4529,  2686, -1052,     0,   417,
+         -398,   214,   -61,     0,     0,     0,     0,     0,
+
+          -79,   180,  -213,     0,   598, -1522,  2389, -2427,
+            0, 24506, 13068, -5289,  1873,     0,  -752,   763,
+         -457,   156,     0,   -28,     0,     0,     0,     0,
+
+          -61,    92,     0,  -323,   861, -1361,  1317,     0,
+        -3885, 19741, 19741, -3885,     0,  1317, -1361,   861,
+         -323,     0,    92,   -61,     0,     0,     0,     0,
+
+          -28,     0,   156,  -457,   763,  -752,     0,  1873,
+        -5289, 13068, 24506,     0, -2427,  2389, -1522,   598,
+            0,  -213,   180,   -79,     0,     0,     0,     0,
+    };
+
+    sse_resample_12k8(4, 5, 20, h, hp50, x, y, n);
+}
+
+#ifndef TEST_SSE
+#define resample_16k_12k8 sse_resample_16k_12k8
+#endif
+
+#endif /* resample_16k_12k8 */
+
+/**
+ * Resample from 32 Khz to 12.8 KHz
+ */
+#ifndef resample_32k_12k8
+
+LC3_HOT static void sse_resample_32k_12k8(
+    struct lc3_ltpf_hp50_state *hp50, const int16_t *x, int16_t *y, int n)
+{
+    static const int16_t alignas(16) h[2*40] = {
+          -30,   -31,    46,   107,     0,  -199,  -162,   209,
+          430,     0,  -681,  -526,   658,  1343,     0, -2264,
+        -1943,  2999,  9871, 13116,  9871,  2999, -1943, -2264,
+            0,  1343,   658,  -526,  -681,     0,   430,   209,
+         -162,  -199,     0,   107,    46,   -31,   -30,     0,
+
+          -14,   -39,     0,    90,    78,  -106,  -229,     0,
+          382,   299,  -376,  -761,     0,  1194,   937, -1214,
+        -2644,     0,  6534, 12253, 12253,  6534,     0, -2644,
+        -1214,   937,  1194,     0,  -761,  -376,   299,   382,
+            0,  -229,  -106,    78,    90,     0,   -39,   -14,
+    };
+
+    sse_resample_12k8(2, 5, 40, h, hp50, x, y, n);
+}
+
+#ifndef TEST_SSE
+#define resample_32k_12k8 sse_resample_32k_12k8
+#endif
+
+#endif /* resample_32k_12k8 */
+
+/**
+ * Resample from 24 Khz to 12.8 KHz
+ */
+#ifndef resample_24k_12k8
+
+LC3_HOT static void sse_resample_24k_12k8(
+    struct lc3_ltpf_hp50_state *hp50, const int16_t *x, int16_t *y, int n)
+{
+    static const int16_t alignas(16) h[8*32] = {
+          -50,    19,   143,   -93,  -290,   278,   485,  -658,
+         -701,  1396,   901, -3019, -1042, 10276, 17488, 10276,
+        -1042, -3019,   901,  1396,  -701,  -658,   485,   278,
+         -290,   -93,   143,    19,   -50,     0,     0,     0,
+
+          -46,     0,   141,   -45,  -305,   185,   543,  -501,
+         -854,  1153,  1249, -2619, -1908,  8712, 17358, 11772,
+            0, -3319,   480,  1593,  -504,  -796,   399,   367,
+         -261,  -142,   138,    40,   -52,    -5,     0,     0,
+
+          -41,   -17,   133,     0,  -304,    91,   574,  -334,
+         -959,   878,  1516, -2143, -2590,  7118, 16971, 13161,
+         1202, -3495,     0,  1731,  -267,  -908,   287,   445,
+         -215,  -188,   125,    62,   -52,   -12,     0,     0,
+
+          -34,   -30,   120,    41,  -291,     0,   577,  -164,
+        -1015,   585,  1697, -1618, -3084,  5534, 16337, 14406,
+         2544, -3526,  -523,  1800,     0,  -985,   152,   509,
+         -156,  -230,   104,    83,   -48,   -19,     0,     0,
+
+          -26,   -41,   103,    76,  -265,   -83,   554,     0,
+        -1023,   288,  1791, -1070, -3393,  3998, 15474, 15474,
+         3998, -3393, -1070,  1791,   288, -1023,     0,   554,
+          -83,  -265,    76,   103,   -41,   -26,     0,     0,
+
+          -19,   -48,    83,   104,  -230,  -156,   509,   152,
+         -985,     0,  1800,  -523, -3526,  2544, 14406, 16337,
+         5534, -3084, -1618,  1697,   585, -1015,  -164,   577,
+            0,  -291,    41,   120,   -30,   -34,     0,     0,
+
+          -12,   -52,    62,   125,  -188,  -215,   445,   287,
+         -908,  -267,  1731,     0, -3495,  1202, 13161, 16971,
+         7118, -2590, -2143,  1516,   878,  -959,  -334,   574,
+           91,  -304,     0,   133,   -17,   -41,     0,     0,
+
+           -5,   -52,    40,   138,  -142,  -261,   367,   399,
+         -796,  -504,  1593,   480, -3319,     0, 11772, 17358,
+         8712, -1908, -2619,  1249,  1153,  -854,  -501,   543,
+          185,  -305,   -45,   141,     0,   -46,     0,     0,
+    };
+
+    sse_resample_12k8(8, 15, 30, h, hp50, x, y, n);
+}
+
+#ifndef TEST_SSE
+#define resample_24k_12k8 sse_resample_24k_12k8
+#endif
+
+#endif /* resample_24k_12k8 */
+
+/**
+ * Resample from 48 Khz to 12.8 KHz
+ */
+#ifndef resample_48k_12k8
+
+LC3_HOT static void sse_resample_48k_12k8(
+    struct lc3_ltpf_hp50_state *hp50, const int16_t *x, int16_t *y, int n)
+{
+    static const int16_t alignas(16) h[4*64] = {
+          -13,   -25,   -20,    10,    51,    71,    38,   -47,
+         -133,  -145,   -42,   139,   277,   242,     0,  -329,
+         -511,  -351,   144,   698,   895,   450,  -535, -1510,
+        -1697,  -521,  1999,  5138,  7737,  8744,  7737,  5138,
+         1999,  -521, -1697, -1510,  -535,   450,   895,   698,
+          144,  -351,  -511,  -329,     0,   242,   277,   139,
+          -42,  -145,  -133,   -47,    38,    71,    51,    10,
+          -20,   -25,   -13,     0,     0,     0,     0,     0,
+
+           -9,   -23,   -24,     0,    41,    71,    52,   -23,
+         -115,  -152,   -78,    92,   254,   272,    76,  -251,
+         -493,  -427,     0,   576,   900,   624,  -262, -1309,
+        -1763,  -954,  1272,  4356,  7203,  8679,  8169,  5886,
+         2767,     0, -1542, -1660,  -809,   240,   848,   796,
+          292,  -252,  -507,  -398,   -82,   199,   288,   183,
+            0,  -130,  -145,   -71,    20,    69,    60,    20,
+          -15,   -26,   -17,    -3,     0,     0,     0,     0,
+
+           -6,   -20,   -26,    -8,    31,    67,    62,     0,
+          -94,  -152,  -108,    45,   223,   287,   143,  -167,
+         -454,  -480,  -134,   439,   866,   758,     0, -1071,
+        -1748, -1295,   601,  3559,  6580,  8485,  8485,  6580,
+         3559,   601, -1295, -1748, -1071,     0,   758,   866,
+          439,  -134,  -480,  -454,  -167,   143,   287,   223,
+           45,  -108,  -152,   -94,     0,    62,    67,    31,
+           -8,   -26,   -20,    -6,     0,     0,     0,     0,
+
+           -3,   -17,   -26,   -15,    20,    60,    69,    20,
+          -71,  -145,  -130,     0,   183,   288,   199,   -82,
+         -398,  -507,  -252,   292,   796,   848,   240,  -809,
+        -1660, -1542,     0,  2767,  5886,  8169,  8679,  7203,
+         4356,  1272,  -954, -1763, -1309,  -262,   624,   900,
+          576,     0,  -427,  -493,  -251,    76,   272,   254,
+           92,   -78,  -152,  -115,   -23,    52,    71,    41,
+            0,   -24,   -23,    -9,     0,     0,     0,     0,
+    };
+
+    sse_resample_12k8(4, 15, 60, h, hp50, x, y, n);
+}
+
+#ifndef TEST_SSE
+#define resample_48k_12k8 sse_resample_48k_12k8
+#endif
+
+#endif /* resample_48k_12k8 */
+
+/**
+ * Resample to 6.4 KHz
+ *
+ * The output `y[k]` is given by the pairs of samples :
+ *   (x[2k-2], x[2k-1]) . (h1, h0) + (x[2k], x[2k+1]) . (h1, h2)
+ *     + (x[2k-4], x[2k-3]) . (0, h2)
+ * so that 4 outputs are processed by 3 loads of 8 samples.
+ */
+#ifndef resample_6k4
+
+LC3_HOT static void sse_resample_6k4(const int16_t *x, int16_t *y, int n)
+{
+    static const int16_t h[] = { 18477, 15424, 8105 };
+
+    const __m128i h10 = _mm_set1_epi32( (uint16_t)h[1] | h[0] << 16 );
+    const __m128i h12 = _mm_set1_epi32( (uint16_t)h[1] | h[2] << 16 );
+    const __m128i h_2 = _mm_set1_epi32(                  h[2] << 16 );
+
+    int k = 0;
+
+    for ( ; k + 4 <= n; k += 4) {
+        __m128i x0 = _mm_loadu_si128((const __m128i *)(x + 2*k - 2));
+        __m128i x1 = _mm_loadu_si128((const __m128i *)(x + 2*k    ));
+        __m128i x2 = _mm_loadu_si128((const __m128i *)(x + 2*k - 4));
+
+        __m128i yk = _mm_add_epi32(
+            _mm_add_epi32(_mm_madd_epi16(x0, h10), _mm_madd_epi16(x1, h12)),
+            _mm_madd_epi16(x2, h_2) );
+
+        yk = _mm_srai_epi32(yk, 16);
+        _mm_storel_epi64((__m128i *)(y + k), _mm_packs_epi32(yk, yk));
+    }
+
+    for (x += 2*k - 1; k < n; k++, x += 2)
+        y[k] = (x[0] * h[0] + (x[-1] + x[1]) * h[1]
+                            + (x[-2] + x[2]) * h[2]) >> 16;
+}
+
+#ifndef TEST_SSE
+#define resample_6k4 sse_resample_6k4
+#endif
+
+#endif /* resample_6k4 */
+
+
+/* ----------------------------------------------------------------------------
+ *  Analysis
+ * -------------------------------------------------------------------------- */
+
+/**
+ * Return dot product of 2 vectors
+ */
+#ifndef dot
+
+LC3_HOT static inline float sse_dot(const int16_t *a, const int16_t *b, int n)
+{
+    __m128i v = _mm_setzero_si128();
+    int i = 0;
+
+#ifdef __AVX2__
+
+    /* --- Process by 16 --- */
+
+    __m256i v2 = _mm256_setzero_si256();
+
+    for ( ; i + 16 <= n; i += 16)
+        v2 = avx_madd_epi64(
+            _mm256_loadu_si256((const __m256i *)(a + i)),
+            _mm256_loadu_si256((const __m256i *)(b + i)), v2);
+
+    v = avx_fold_128(v2);
+
+#endif /* __AVX2__ */
+
+    /* --- Process by 8 --- */
+
+    for ( ; i + 8 <= n; i += 8)
+        v = sse_madd_epi64(
+            _mm_loadu_si128((const __m128i *)(a + i)),
+            _mm_loadu_si128((const __m128i *)(b + i)), v);
+
+    int64_t v64 = sse_hadd_epi64(v) + ((int64_t)n << 15);
+
+    int32_t v32 = (v64 + (1 << 5)) >> 6;
+    return (float)v32;
+}
+
+#ifndef TEST_SSE
+#define dot sse_dot
+#endif
+
+#endif /* dot */
+
+/**
+ * Return vector of correlations
+ *
+ * The correlations are processed by 4 lags, sharing the loads of `a`.
+ */
+#ifndef correlate
+
+LC3_HOT static void sse_correlate(
+    const int16_t *a, const int16_t *b, int n, float *y, int nc)
+{
+    for ( ; nc >= 4; nc -= 4, b -= 4) {
+        __m128i v[4];
+
+#ifdef __AVX2__
+
+        __m256i v2[4];
+
+        for (int j = 0; j < 4; j++)
+            v2[j] = _mm256_setzero_si256();
+
+        for (int i = 0; i < n; i += 16) {
+            __m256i ai = _mm256_loadu_si256((const __m256i *)(a + i));
+
+            for (int j = 0; j < 4; j++)
+                v2[j] = avx_madd_epi64(ai,
+                    _mm256_loadu_si256((const __m256i *)(b - j + i)), v2[j]);
+        }
+
+        for (int j = 0; j < 4; j++)
+            v[j] = avx_fold_128(v2[j]);
+
+#else /* __AVX2__ */
+
+        for (int j = 0; j < 4; j++)
+            v[j] = _mm_setzero_si128();
+
+        for (int i = 0; i < n; i += 8) {
+            __m128i ai = _mm_loadu_si128((const __m128i *)(a + i));
+
+            for (int j = 0; j < 4; j++)
+                v[j] = sse_madd_epi64(ai,
+                    _mm_loadu_si128((const __m128i *)(b - j + i)), v[j]);
+        }
+
+#endif /* __AVX2__ */
+
+        for (int j = 0; j < 4; j++) {
+            int64_t v64 = sse_hadd_epi64(v[j]) + ((int64_t)n << 15);
+            *(y++) = (float)((int32_t)((v64 + (1 << 5)) >> 6));
+        }
+    }
+
+    for ( ; nc > 0; nc--)
+        *(y++) = dot(a, b--, n);
+}
+
+#ifndef TEST_SSE
+#define correlate sse_correlate
+#endif
+
+#endif /* correlate */
+
+#endif /* __SSE4_1__ */
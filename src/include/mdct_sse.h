@@ -0,0 +1,564 @@
+/******************************************************************************
+ *
+ *  Copyright 2022 Google LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#if defined(__SSE4_1__) && !defined(TEST_NEON) || defined(TEST_SSE)
+
+#include <immintrin.h>
+
+
+/* ----------------------------------------------------------------------------
+ *  Helpers
+ *
+ *  Complex numbers are kept interleaved `re, im`, as in memory,
+ *  so that a 128 bits vector holds 2 complex, a 256 bits vector 4.
+ *  Multiply-add are fused when the target enables FMA.
+ * -------------------------------------------------------------------------- */
+
+/**
+ * Load / Store a single complex, in low part of a vector
+ */
+static inline __m128 sse_load_c1(const struct lc3_complex *p)
+{
+    return _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)p);
+}
+
+static inline void sse_store_c1(struct lc3_complex *p, __m128 v)
+{
+    _mm_storel_pi((__m64 *)p, v);
+}
+
+/**
+ * Return `a * b + c`, and `c - a * b`
+ */
+static inline __m128 sse_madd(__m128 a, __m128 b, __m128 c)
+{
+#ifdef __FMA__
+    return _mm_fmadd_ps(a, b, c);
+#else
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+}
+
+static inline __m128 sse_msub(__m128 a, __m128 b, __m128 c)
+{
+#ifdef __FMA__
+    return _mm_fnmadd_ps(a, b, c);
+#else
+    return _mm_sub_ps(c, _mm_mul_ps(a, b));
+#endif
+}
+
+/**
+ * Complex multiplication `x * w`, and `x * conj(w)`
+ */
+static inline __m128 sse_cmul(__m128 x, __m128 w)
+{
+    __m128 w_re = _mm_moveldup_ps(w);
+    __m128 w_im = _mm_movehdup_ps(w);
+    __m128 x_sw = _mm_shuffle_ps(x, x, _MM_SHUFFLE(2, 3, 0, 1));
+
+#ifdef __FMA__
+    return _mm_fmaddsub_ps(x, w_re, _mm_mul_ps(x_sw, w_im));
+#else
+    return _mm_addsub_ps(_mm_mul_ps(x, w_re), _mm_mul_ps(x_sw, w_im));
+#endif
+}
+
+static inline __m128 sse_cmulc(__m128 x, __m128 w)
+{
+    __m128 w_re = _mm_moveldup_ps(w);
+    __m128 w_im = _mm_movehdup_ps(w);
+    __m128 x_sw = _mm_shuffle_ps(x, x, _MM_SHUFFLE(2, 3, 0, 1));
+
+#ifdef __FMA__
+    return _mm_fmsubadd_ps(x, w_re, _mm_mul_ps(x_sw, w_im));
+#else
+    return _mm_addsub_ps(_mm_mul_ps(x, w_re),
+        _mm_mul_ps(x_sw, _mm_xor_ps(w_im, _mm_set1_ps(-0.f))));
+#endif
+}
+
+/**
+ * Reverse the order of the 4 floats of a vector
+ */
+static inline __m128 sse_reverse(__m128 x)
+{
+    return _mm_shuffle_ps(x, x, _MM_SHUFFLE(0, 1, 2, 3));
+}
+
+#if defined(__AVX2__) && defined(__FMA__)
+
+static inline __m256 avx_cmul(__m256 x, __m256 w)
+{
+    __m256 w_re = _mm256_moveldup_ps(w);
+    __m256 w_im = _mm256_movehdup_ps(w);
+    __m256 x_sw = _mm256_permute_ps(x, _MM_SHUFFLE(2, 3, 0, 1));
+
+    return _mm256_fmaddsub_ps(x, w_re, _mm256_mul_ps(x_sw, w_im));
+}
+
+#endif /* __AVX2__ && __FMA__ */
+
+
+/* ----------------------------------------------------------------------------
+ *  FFT processing
+ * -------------------------------------------------------------------------- */
+
+/**
+ * FFT 5 Points
+ * The number of interleaved transform `n` assumed to be even
+ */
+#ifndef fft_5
+
+LC3_HOT static inline void sse_fft_5(
+    const struct lc3_complex *x, struct lc3_complex *y, int n)
+{
+    const __m128 cos1 = _mm_set1_ps(  0.3090169944 );
+    const __m128 cos2 = _mm_set1_ps( -0.8090169944 );
+    const __m128 sin1 = _mm_setr_ps(
+         0.9510565163, -0.9510565163,  0.9510565163, -0.9510565163 );
+    const __m128 sin2 = _mm_setr_ps(
+         0.5877852523, -0.5877852523,  0.5877852523, -0.5877852523 );
+
+    for (int i = 0; i < n; i += 2, x += 2, y += 10) {
+
+        __m128 y0, y1, y2, y3, y4;
+
+        __m128 x0 = _mm_loadu_ps( (const float *)(x + 0*n) );
+        __m128 x1 = _mm_loadu_ps( (const float *)(x + 1*n) );
+        __m128 x2 = _mm_loadu_ps( (const float *)(x + 2*n) );
+        __m128 x3 = _mm_loadu_ps( (const float *)(x + 3*n) );
+        __m128 x4 = _mm_loadu_ps( (const float *)(x + 4*n) );
+
+        __m128 s14 = _mm_add_ps(x1, x4);
+        __m128 s23 = _mm_add_ps(x2, x3);
+
+        __m128 d14 = _mm_sub_ps(x1, x4);
+        __m128 d23 = _mm_sub_ps(x2, x3);
+        d14 = _mm_shuffle_ps(d14, d14, _MM_SHUFFLE(2, 3, 0, 1));
+        d23 = _mm_shuffle_ps(d23, d23, _MM_SHUFFLE(2, 3, 0, 1));
+
+        y0 = _mm_add_ps( x0, _mm_add_ps(s14, s23) );
+
+        y4 = sse_madd( s14, cos1, x0 );
+        y4 = sse_madd( s23, cos2, y4 );
+
+        y1 = sse_madd( d14, sin1, y4 );
+        y1 = sse_madd( d23, sin2, y1 );
+
+        y4 = sse_msub( d14, sin1, y4 );
+        y4 = sse_msub( d23, sin2, y4 );
+
+        y3 = sse_madd( s14, cos2, x0 );
+        y3 = sse_madd( s23, cos1, y3 );
+
+        y2 = sse_madd( d14, sin2, y3 );
+        y2 = sse_msub( d23, sin1, y2 );
+
+        y3 = sse_msub( d14, sin2, y3 );
+        y3 = sse_madd( d23, sin1, y3 );
+
+        _mm_storel_pi( (__m64 *)(y + 0), y0 );
+        _mm_storel_pi( (__m64 *)(y + 1), y1 );
+        _mm_storel_pi( (__m64 *)(y + 2), y2 );
+        _mm_storel_pi( (__m64 *)(y + 3), y3 );
+        _mm_storel_pi( (__m64 *)(y + 4), y4 );
+
+        _mm_storeh_pi( (__m64 *)(y + 5), y0 );
+        _mm_storeh_pi( (__m64 *)(y + 6), y1 );
+        _mm_storeh_pi( (__m64 *)(y + 7), y2 );
+        _mm_storeh_pi( (__m64 *)(y + 8), y3 );
+        _mm_storeh_pi( (__m64 *)(y + 9), y4 );
+    }
+}
+
+#ifndef TEST_SSE
+#define fft_5 sse_fft_5
+#endif
+
+#endif /* fft_5 */
+
+/**
+ * FFT Butterfly 3 Points
+ */
+#ifndef fft_bf3
+
+LC3_HOT static inline void sse_fft_bf3(
+    const struct lc3_fft_bf3_twiddles *twiddles,
+    const struct lc3_complex *x, struct lc3_complex *y, int n)
+{
+    int n3 = twiddles->n3;
+    const struct lc3_complex (*w0_ptr)[2] = twiddles->t;
+    const struct lc3_complex (*w1_ptr)[2] = w0_ptr + n3;
+    const struct lc3_complex (*w2_ptr)[2] = w1_ptr + n3;
+
+    const struct lc3_complex *x0_ptr = x;
+    const struct lc3_complex *x1_ptr = x0_ptr + n*n3;
+    const struct lc3_complex *x2_ptr = x1_ptr + n*n3;
+
+    struct lc3_complex *y0_ptr = y;
+    struct lc3_complex *y1_ptr = y0_ptr + n3;
+    struct lc3_complex *y2_ptr = y1_ptr + n3;
+
+    const struct lc3_complex (*wn_ptr[3])[2] = { w0_ptr, w1_ptr, w2_ptr };
+
+    for (int j, i = 0; i < n; i++,
+            y0_ptr += 3*n3, y1_ptr += 3*n3, y2_ptr += 3*n3) {
+
+        struct lc3_complex *yn_ptr[3] = { y0_ptr, y1_ptr, y2_ptr };
+
+        j = 0;
+
+#if defined(__AVX2__) && defined(__FMA__)
+
+        /* --- Process by 4 --- */
+
+        for ( ; j + 4 <= n3; j += 4,
+                x0_ptr += 4, x1_ptr += 4, x2_ptr += 4) {
+
+            __m256 x0 = _mm256_loadu_ps( (const float *)x0_ptr );
+            __m256 x1 = _mm256_loadu_ps( (const float *)x1_ptr );
+            __m256 x2 = _mm256_loadu_ps( (const float *)x2_ptr );
+
+            for (int k = 0; k < 3; k++) {
+                __m256d wa = _mm256_loadu_pd( (const double *)(wn_ptr[k] + j  ) );
+                __m256d wb = _mm256_loadu_pd( (const double *)(wn_ptr[k] + j+2) );
+
+                __m256 w1 = _mm256_castpd_ps( _mm256_permute4x64_pd(
+                    _mm256_unpacklo_pd(wa, wb), _MM_SHUFFLE(3, 1, 2, 0)) );
+                __m256 w2 = _mm256_castpd_ps( _mm256_permute4x64_pd(
+                    _mm256_unpackhi_pd(wa, wb), _MM_SHUFFLE(3, 1, 2, 0)) );
+
+                __m256 yn = _mm256_add_ps( x0, avx_cmul(x1, w1) );
+                yn = _mm256_add_ps( yn, avx_cmul(x2, w2) );
+                _mm256_storeu_ps( (float *)(yn_ptr[k] + j), yn );
+            }
+        }
+
+#endif /* __AVX2__ && __FMA__ */
+
+        /* --- Process by pair --- */
+
+        for ( ; j + 2 <= n3; j += 2,
+                x0_ptr += 2, x1_ptr += 2, x2_ptr += 2) {
+
+            __m128 x0 = _mm_loadu_ps( (const float *)x0_ptr );
+            __m128 x1 = _mm_loadu_ps( (const float *)x1_ptr );
+            __m128 x2 = _mm_loadu_ps( (const float *)x2_ptr );
+
+            for (int k = 0; k < 3; k++) {
+                __m128 wa = _mm_loadu_ps( (const float *)(wn_ptr[k] + j  ) );
+                __m128 wb = _mm_loadu_ps( (const float *)(wn_ptr[k] + j+1) );
+
+                __m128 yn = _mm_add_ps( x0, sse_cmul(x1, _mm_movelh_ps(wa, wb)) );
+                yn = _mm_add_ps( yn, sse_cmul(x2, _mm_movehl_ps(wb, wa)) );
+                _mm_storeu_ps( (float *)(yn_ptr[k] + j), yn );
+            }
+        }
+
+        /* --- Last iteration --- */
+
+        if (j < n3) {
+
+            __m128 x0 = sse_load_c1( x0_ptr++ );
+            __m128 x1 = sse_load_c1( x1_ptr++ );
+            __m128 x2 = sse_load_c1( x2_ptr++ );
+
+            for (int k = 0; k < 3; k++) {
+                __m128 wn = _mm_loadu_ps( (const float *)(wn_ptr[k] + j) );
+
+                __m128 yn = _mm_add_ps( x0, sse_cmul(x1, wn) );
+                yn = _mm_add_ps( yn, sse_cmul(x2, _mm_movehl_ps(wn, wn)) );
+                sse_store_c1( yn_ptr[k] + j, yn );
+            }
+        }
+    }
+}
+
+#ifndef TEST_SSE
+#define fft_bf3 sse_fft_bf3
+#endif
+
+#endif /* fft_bf3 */
+
+/**
+ * FFT Butterfly 2 Points
+ */
+#ifndef fft_bf2
+
+LC3_HOT static inline void sse_fft_bf2(
+    const struct lc3_fft_bf2_twiddles *twiddles,
+    const struct lc3_complex *x, struct lc3_complex *y, int n)
+{
+    int n2 = twiddles->n2;
+    const struct lc3_complex *w_ptr = twiddles->t;
+
+    const struct lc3_complex *x0_ptr = x;
+    const struct lc3_complex *x1_ptr = x0_ptr + n*n2;
+
+    struct lc3_complex *y0_ptr = y;
+    struct lc3_complex *y1_ptr = y0_ptr + n2;
+
+    for (int j, i = 0; i < n; i++, y0_ptr += 2*n2, y1_ptr += 2*n2) {
+
+        j = 0;
+
+#if defined(__AVX2__) && defined(__FMA__)
+
+        /* --- Process by 4 --- */
+
+        for ( ; j + 4 <= n2; j += 4, x0_ptr += 4, x1_ptr += 4) {
+
+            __m256 x0 = _mm256_loadu_ps( (const float *)x0_ptr );
+            __m256 x1 = _mm256_loadu_ps( (const float *)x1_ptr );
+            __m256 w = _mm256_loadu_ps( (const float *)(w_ptr + j) );
+
+            __m256 x1w = avx_cmul(x1, w);
+
+            _mm256_storeu_ps( (float *)(y0_ptr + j), _mm256_add_ps(x0, x1w) );
+            _mm256_storeu_ps( (float *)(y1_ptr + j), _mm256_sub_ps(x0, x1w) );
+        }
+
+#endif /* __AVX2__ && __FMA__ */
+
+        /* --- Process by pair --- */
+
+        for ( ; j + 2 <= n2; j += 2, x0_ptr += 2, x1_ptr += 2) {
+
+            __m128 x0 = _mm_loadu_ps( (const float *)x0_ptr );
+            __m128 x1 = _mm_loadu_ps( (const float *)x1_ptr );
+            __m128 w = _mm_loadu_ps( (const float *)(w_ptr + j) );
+
+            __m128 x1w = sse_cmul(x1, w);
+
+            _mm_storeu_ps( (float *)(y0_ptr + j), _mm_add_ps(x0, x1w) );
+            _mm_storeu_ps( (float *)(y1_ptr + j), _mm_sub_ps(x0, x1w) );
+        }
+
+        /* --- Last iteration --- */
+
+        if (j < n2) {
+
+            __m128 x0 = sse_load_c1( x0_ptr++ );
+            __m128 x1 = sse_load_c1( x1_ptr++ );
+            __m128 w = sse_load_c1( w_ptr + j );
+
+            __m128 x1w = sse_cmul(x1, w);
+
+            sse_store_c1( y0_ptr + j, _mm_add_ps(x0, x1w) );
+            sse_store_c1( y1_ptr + j, _mm_sub_ps(x0, x1w) );
+        }
+    }
+}
+
+#ifndef TEST_SSE
+#define fft_bf2 sse_fft_bf2
+#endif
+
+#endif /* fft_bf2 */
+
+
+/* ----------------------------------------------------------------------------
+ *  MDCT processing
+ * -------------------------------------------------------------------------- */
+
+/**
+ * Windowing of samples before MDCT
+ *
+ * The full windowed sequence is `u = { d[0..nd-1], x[0..ns-1] }`, giving :
+ *   y[ns/2-1-k] = u[k] w[k] - u[ns-1-k] w[ns-1-k]                , k < ns/2
+ *   y[ns/2  +k] = u[ns+k] w[ns+k] + u[2ns-1-k] w[2ns-1-k]        , k < ns/2
+ * with the second term of `y[ns/2+k]` null for `2ns-1-k >= ns+nd`.
+ * The delayed samples are updated once the whole window is computed.
+ */
+#ifndef mdct_window
+
+LC3_HOT static inline void sse_mdct_window(
+    enum lc3_dt dt, enum lc3_srate sr, const float *x, float *d, float *y)
+{
+    int ns = LC3_NS(dt, sr), nd = LC3_ND(dt, sr);
+    int n2 = ns >> 1, nz = ns - nd;
+
+    const float *w = lc3_mdct_win[dt][sr];
+    int k = 0;
+
+    /* --- Samples `u[ns-1-k]` from current frame --- */
+
+    for ( ; k + 4 <= nz; k += 4) {
+        __m128 d0 = _mm_loadu_ps(d + k);
+        __m128 w0 = _mm_loadu_ps(w + k);
+        __m128 x1 = sse_reverse( _mm_loadu_ps(x + nz-4-k) );
+        __m128 w1 = sse_reverse( _mm_loadu_ps(w + ns-4-k) );
+        __m128 x2 = _mm_loadu_ps(x + nz+k);
+        __m128 w2 = _mm_loadu_ps(w + ns+k);
+
+        _mm_storeu_ps(y + n2-4-k,
+            sse_reverse( sse_msub(x1, w1, _mm_mul_ps(d0, w0)) ));
+        _mm_storeu_ps(y + n2+k, _mm_mul_ps(x2, w2));
+    }
+
+    for ( ; k < nz; k++) {
+        y[n2-1-k] = d[k] * w[k] - x[nz-1-k] * w[ns-1-k];
+        y[n2  +k] = x[nz+k] * w[ns+k];
+    }
+
+    /* --- Samples `u[ns-1-k]` from delayed ones --- */
+
+    for ( ; k + 4 <= n2; k += 4) {
+        __m128 d0 = _mm_loadu_ps(d + k);
+        __m128 w0 = _mm_loadu_ps(w + k);
+        __m128 d1 = sse_reverse( _mm_loadu_ps(d + ns-4-k) );
+        __m128 w1 = sse_reverse( _mm_loadu_ps(w + ns-4-k) );
+        __m128 x2 = _mm_loadu_ps(x + nz+k);
+        __m128 w2 = _mm_loadu_ps(w + ns+k);
+        __m128 x3 = sse_reverse( _mm_loadu_ps(x + 2*ns-nd-4-k) );
+        __m128 w3 = sse_reverse( _mm_loadu_ps(w + 2*ns-4-k) );
+
+        _mm_storeu_ps(y + n2-4-k,
+            sse_reverse( sse_msub(d1, w1, _mm_mul_ps(d0, w0)) ));
+        _mm_storeu_ps(y + n2+k,
+            sse_madd(x3, w3, _mm_mul_ps(x2, w2)));
+    }
+
+    for ( ; k < n2; k++) {
+        y[n2-1-k] = d[k] * w[k] - d[ns-1-k] * w[ns-1-k];
+        y[n2  +k] = x[nz+k] * w[ns+k] + x[2*ns-nd-1-k] * w[2*ns-1-k];
+    }
+
+    /* --- Update delayed samples --- */
+
+    memcpy(d, x + nz, nd * sizeof(*d));
+}
+
+#ifndef TEST_SSE
+#define mdct_window sse_mdct_window
+#endif
+
+#endif /* mdct_window */
+
+/**
+ * Pre-rotate MDCT coefficients of N/2 points, before FFT N/4 points FFT
+ *
+ * The rotation of the pairs `x[2i], x[2n4-1-2i]` and `x[2i+1], x[2n4-2-2i]`
+ * are expressed as `(x0 + j x1) * swap(w[i])` and `conj((x0 + j x1) * w)`.
+ */
+#ifndef mdct_pre_fft
+
+LC3_HOT static inline void sse_mdct_pre_fft(
+    const struct lc3_mdct_rot_def *def, const float *x, struct lc3_complex *y)
+{
+    int n4 = def->n4;
+    const struct lc3_complex *w = def->w;
+
+    const __m128 conj = _mm_setr_ps(0.f, -0.f, 0.f, -0.f);
+    int i = 0;
+
+    for ( ; i + 2 <= (n4 >> 1); i += 2) {
+
+        __m128 xa = _mm_loadu_ps(x + 2*i);
+        __m128 xb = _mm_loadu_ps(x + 2*n4-4-2*i);
+
+        __m128 su = _mm_shuffle_ps(xa, xb, _MM_SHUFFLE(1, 3, 2, 0));
+        __m128 zu = _mm_shuffle_ps(su, su, _MM_SHUFFLE(3, 1, 2, 0));
+
+        __m128 sv = _mm_shuffle_ps(xa, xb, _MM_SHUFFLE(2, 0, 3, 1));
+        __m128 zv = _mm_shuffle_ps(sv, sv, _MM_SHUFFLE(3, 0, 2, 1));
+
+        __m128 wu = _mm_loadu_ps( (const float *)(w + i) );
+        __m128 wv = _mm_loadu_ps( (const float *)(w + n4-2-i) );
+
+        wu = _mm_shuffle_ps(wu, wu, _MM_SHUFFLE(2, 3, 0, 1));
+
+        _mm_storeu_ps( (float *)(y + i), sse_cmul(zu, wu) );
+        _mm_storeu_ps( (float *)(y + n4-2-i),
+            _mm_xor_ps(sse_cmul(zv, wv), conj) );
+    }
+
+    for ( ; i < (n4 >> 1); i++) {
+        float u0 = x[2*i], u1 = x[2*n4-1-2*i];
+        float v0 = x[2*i+1], v1 = x[2*n4-2-2*i];
+        struct lc3_complex uw = w[i], vw = w[n4-1-i];
+
+        y[i].re = - u1 * uw.re + u0 * uw.im;
+        y[i].im =   u0 * uw.re + u1 * uw.im;
+
+        y[n4-1-i].re = - v1 * vw.im + v0 * vw.re;
+        y[n4-1-i].im = - v0 * vw.im - v1 * vw.re;
+    }
+}
+
+#ifndef TEST_SSE
+#define mdct_pre_fft sse_mdct_pre_fft
+#endif
+
+#endif /* mdct_pre_fft */
+
+/**
+ * Post-rotate FFT N/4 points coefficients, resulting MDCT N points
+ *
+ * With `a = x[n8+k] conj(w[n8+k])` and `b = x[n8-1-k] conj(w[n8-1-k])` :
+ *   y[n4+2k] = re(a), y[n4+2k+1] = -im(b)
+ *   y[n4-1-2k] = -im(a), y[n4-2-2k] = re(b)
+ */
+#ifndef mdct_post_fft
+
+LC3_HOT static inline void sse_mdct_post_fft(
+    const struct lc3_mdct_rot_def *def, const struct lc3_complex *x, float *y)
+{
+    int n4 = def->n4, n8 = n4 >> 1;
+    const struct lc3_complex *w = def->w;
+
+    const __m128 neg = _mm_set1_ps(-0.f);
+    int k = 0;
+
+    for ( ; k + 2 <= n8; k += 2) {
+
+        __m128 a = sse_cmulc(
+            _mm_loadu_ps( (const float *)(x + n8+k) ),
+            _mm_loadu_ps( (const float *)(w + n8+k) ) );
+
+        __m128 b = sse_cmulc(
+            _mm_loadu_ps( (const float *)(x + n8-2-k) ),
+            _mm_loadu_ps( (const float *)(w + n8-2-k) ) );
+
+        __m128 u = _mm_shuffle_ps(a, _mm_xor_ps(b, neg), _MM_SHUFFLE(1, 3, 2, 0));
+        __m128 v = _mm_shuffle_ps(b, _mm_xor_ps(a, neg), _MM_SHUFFLE(1, 3, 2, 0));
+
+        _mm_storeu_ps(y + n4+2*k, _mm_shuffle_ps(u, u, _MM_SHUFFLE(3, 1, 2, 0)));
+        _mm_storeu_ps(y + n4-4-2*k, _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 1, 2, 0)));
+    }
+
+    for ( ; k < n8; k++) {
+        struct lc3_complex x0 = x[n8+k], x1 = x[n8-1-k];
+        struct lc3_complex w0 = w[n8+k], w1 = w[n8-1-k];
+
+        y[n4+2*k  ] = x0.im * w0.im + x0.re * w0.re;
+        y[n4+2*k+1] = x1.re * w1.im - x1.im * w1.re;
+
+        y[n4-1-2*k] = x0.re * w0.im - x0.im * w0.re;
+        y[n4-2-2*k] = x1.im * w1.im + x1.re * w1.re;
+    }
+}
+
+#ifndef TEST_SSE
+#define mdct_post_fft sse_mdct_post_fft
+#endif
+
+#endif /* mdct_post_fft */
+
+#endif /* __SSE4_1__ */
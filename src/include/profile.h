@@ -0,0 +1,87 @@
+/******************************************************************************
+ *
+ *  Copyright 2022 Google LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/**
+ * LC3 - Profiling of the encoders and decoders
+ *
+ * When built with `LC3_PROFILE` defined, the stages of the encoding and
+ * decoding accumulate their cycles, and the frames their counters, in the
+ * `stats` of the states. Otherwise, the macros expand to nothing.
+ */
+
+#ifndef __LC3_PROFILE_H
+#define __LC3_PROFILE_H
+
+#include "common.h"
+
+#ifdef LC3_PROFILE
+
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+
+/**
+ * Return a cycle count, from an unspecified point in the past
+ * On x86 and AArch64 the timestamp counters are read, and the
+ * processor time of `clock()` is used otherwise.
+ */
+static inline uint64_t lc3_profile_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+
+#elif defined(__aarch64__)
+    uint64_t v;
+    __asm__ volatile ("mrs %0, cntvct_el0" : "=r" (v));
+    return v;
+
+#else
+    return clock();
+
+#endif
+}
+
+
+/**
+ * Profiling macros
+ *   BEGIN(t)           Declare `t`, and take the start cycle count
+ *   END(t, counter)    Add to `counter` the cycles elapsed since `t`
+ *   COUNT(counter, v)  Add `v` to `counter`
+ */
+
+#define LC3_PROFILE_BEGIN(t) \
+    uint64_t t = lc3_profile_cycles()
+
+#define LC3_PROFILE_END(t, counter) \
+    ( (counter) += lc3_profile_cycles() - (t) )
+
+#define LC3_PROFILE_COUNT(counter, v) \
+    ( (counter) += (v) )
+
+#else /* LC3_PROFILE */
+
+#define LC3_PROFILE_BEGIN(t)           ((void)0)
+#define LC3_PROFILE_END(t, counter)    ((void)0)
+#define LC3_PROFILE_COUNT(counter, v)  ((void)0)
+
+#endif /* LC3_PROFILE */
+
+#endif /* __LC3_PROFILE_H */
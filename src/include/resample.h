@@ -0,0 +1,207 @@
+#ifndef LC3_RESAMPLE_H
+#define LC3_RESAMPLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <lc3.h>
+
+/**
+ * Polyphase resampler, of ratio `up / down`
+ * | nch         Number of channels, interleaved in input and output
+ * | up, down    Upsampling and downsampling factors
+ * | ntaps       Number of taps of each phase of the filter
+ * | pos         Position of the next output, in `1 / up` input samples
+ * | nx, xsiz    Input samples buffered, and capacity of each channel,
+ * |             which bounds the input samples of a run
+ * | h           Filter, `up` phases of `ntaps` coefficients
+ * | x           Input samples of each channel, deinterleaved
+ *
+ * The filter is centered on the outputs, which are aligned to the inputs,
+ * the lookahead of `ntaps / 2` input samples is the only delay.
+ */
+typedef struct {
+    int nch;
+    int up, down;
+    int ntaps;
+    int64_t pos;
+    int nx, xsiz;
+    float * h;
+    float * x;
+} resampler_t;
+
+/**
+ * Resampling of the frames of the file and stream coders
+ * | rs          Resampler
+ * | fmt         PCM format, input of the encoders, output of the decoders
+ * | max_out     Maximum number of output samples of a frame
+ * | pcm         PCM samples of a frame, interleaved
+ * | x           Float samples of a frame, interleaved
+ *
+ * The encoders read a frame in `pcm`, resampled to `x` as their input,
+ * the decoders output float frames, resampled to `pcm` as their output.
+ */
+typedef struct {
+    resampler_t rs;
+    enum lc3_pcm_format fmt;
+    int max_out;
+    int8_t * pcm;
+    float * x;
+} resample_coder_t;
+
+/**
+ * @brief return the LC3 samplerate coding a PCM samplerate
+ *
+ * @param hz - [in] PCM samplerate, LC3 samplerates are returned as is,
+ *                  11025, 22050, 88200 and 96000 Hz are resampled
+ *
+ * @return LC3 samplerate, or 0 when the samplerate is not handled
+*/
+extern
+int resample_lc3_hz(const int hz);
+
+/**
+ * @brief return true when the codec converts itself between samplerates
+ *
+ * @param lc3_hz - [in] samplerate of the LC3 stream
+ * @param pcm_hz - [in] samplerate of the PCM samples
+ *
+ * @return true when both are LC3 samplerates, and the 44.1 kHz one
+ *         is not mixed with the others, which the codec can't convert
+*/
+extern
+bool resample_lc3_native(const int lc3_hz, const int pcm_hz);
+
+/**
+ * @brief return the samplerate to decode a stream, before resampling
+ *
+ * @param lc3_hz - [in] samplerate of the LC3 stream
+ * @param pcm_hz - [in] samplerate of the PCM output
+ *
+ * @return 'pcm_hz' when the codec converts itself the samplerate,
+ *         otherwise the samplerate to resample from, the closest to
+ *         'pcm_hz' the codec can give, within the stream samplerate
+*/
+extern
+int resample_dec_hz(const int lc3_hz, const int pcm_hz);
+
+/**
+ * @brief init a resampler
+ *
+ * @param rs - [out] resampler
+ * @param in_hz, out_hz - [in] input and output samplerates
+ * @param nch - [in] number of channels
+ * @param max_in - [in] number of input samples of a frame, the lookahead
+ *                      of the filter is added to the capacity
+ *
+ * @return 0 = ok, -1 = bad parameters or allocation failure
+*/
+extern
+int resampler_init(resampler_t * const rs,
+                   const int in_hz,
+                   const int out_hz,
+                   const int nch,
+                   const int max_in);
+
+/**
+ * @brief release the memory of a resampler
+*/
+extern
+void resampler_free(resampler_t * const rs);
+
+/**
+ * @brief return the number of input samples needed to output 'nout' ones
+*/
+extern
+int resampler_needed(const resampler_t * const rs,
+                     const int nout);
+
+/**
+ * @brief resample interleaved samples, the state is carried over runs
+ *
+ * @param rs - [in/out] resampler
+ * @param fmt - [in] PCM format of the input
+ * @param in - [in] input samples, 'nin' by channel
+ * @param nin - [in] number of input samples, within the capacity
+ * @param out - [out] output samples, as float in range -1 to 1
+ * @param max_out - [in] maximum number of output samples
+ *
+ * @return number of output samples, by channel
+*/
+extern
+int resampler_run(resampler_t * const rs,
+                  const enum lc3_pcm_format fmt,
+                  const void * const in,
+                  const int nin,
+                  float * const out,
+                  const int max_out);
+
+/**
+ * @brief convert float samples, in range -1 to 1, to PCM samples
+ *
+ * @param fmt - [in] PCM format, 16 or 24 bits
+ * @param x - [in] float samples
+ * @param n - [in] number of samples, all channels counted
+ * @param pcm - [out] PCM samples, rounded and saturated
+*/
+extern
+void resample_to_pcm(const enum lc3_pcm_format fmt,
+                     const float * const x,
+                     const int n,
+                     void * const pcm);
+
+/**
+ * @brief init the resampling of the frames of a coder
+ *
+ * @param rc - [out] resampling of the coder
+ * @param in_hz, out_hz - [in] input and output samplerates
+ * @param nch - [in] number of channels
+ * @param fmt - [in] PCM format of the samples read or written
+ * @param max_in - [in] number of input samples of a frame
+ *
+ * @return 0 = ok, -1 = bad parameters or allocation failure
+*/
+extern
+int resample_coder_init(resample_coder_t * const rc,
+                        const int in_hz,
+                        const int out_hz,
+                        const int nch,
+                        const enum lc3_pcm_format fmt,
+                        const int max_in);
+
+/**
+ * @brief release the memory of the resampling of a coder
+*/
+extern
+void resample_coder_free(resample_coder_t * const rc);
+
+/**
+ * @brief resample the PCM samples read in 'pcm', to the float ones of 'x'
+ *
+ * @param rc - [in/out] resampling of the coder
+ * @param nin - [in] number of PCM samples, as needed for 'nout' samples
+ * @param nout - [in] number of output samples, of a frame
+ *
+ * @return the float samples, 'nout' by channel
+*/
+extern
+const float * resample_coder_from_pcm(resample_coder_t * const rc,
+                                      const int nin,
+                                      const int nout);
+
+/**
+ * @brief resample float samples, to the PCM ones of 'pcm'
+ *
+ * @param rc - [in/out] resampling of the coder
+ * @param x - [in] float samples, 'nin' by channel
+ * @param nin - [in] number of float samples
+ * @param max_out - [in] maximum number of output samples
+ *
+ * @return number of PCM samples output, by channel
+*/
+extern
+int resample_coder_to_pcm(resample_coder_t * const rc,
+                          const float * const x,
+                          const int nin,
+                          const int max_out);
+
+#endif//LC3_RESAMPLE_H
@@ -0,0 +1,262 @@
+/******************************************************************************
+ *
+ *  Copyright 2022 Google LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#if defined(__SSE4_1__) && !defined(TEST_NEON) || defined(TEST_SSE)
+
+#include <immintrin.h>
+
+
+/**
+ * Import
+ */
+
+static const float dct16_m[16][16];
+
+
+/* ----------------------------------------------------------------------------
+ *  Helpers
+ * -------------------------------------------------------------------------- */
+
+/**
+ * Return the index of the first minimum of 4 values, and its value
+ * v, idx          Values and their indexes
+ * vmin            Return the minimum value
+ */
+static inline int sse_argmin_ps(__m128 v, __m128i idx, float *vmin)
+{
+    __m128 m = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = _mm_min_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    __m128i i = _mm_blendv_epi8(_mm_set1_epi32(INT32_MAX),
+        idx, _mm_castps_si128(_mm_cmpeq_ps(v, m)));
+    i = _mm_min_epi32(i, _mm_shuffle_epi32(i, _MM_SHUFFLE(1, 0, 3, 2)));
+    i = _mm_min_epi32(i, _mm_shuffle_epi32(i, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    *vmin = _mm_cvtss_f32(m);
+    return _mm_cvtsi128_si32(i);
+}
+
+
+/* ----------------------------------------------------------------------------
+ *  DCT-16
+ * -------------------------------------------------------------------------- */
+
+/**
+ * Forward DCT-16 transformation
+ * The 16 outputs are kept in 4 vectors, and the inputs accumulated
+ * in their order, as the scalar version.
+ */
+#ifndef dct16_forward
+
+LC3_HOT static void sse_dct16_forward(const float *x, float *y)
+{
+    __m128 y0 = _mm_setzero_ps(), y1 = _mm_setzero_ps();
+    __m128 y2 = _mm_setzero_ps(), y3 = _mm_setzero_ps();
+
+    for (int j = 0; j < 16; j++) {
+        __m128 xj = _mm_set1_ps(x[j]);
+        const float *m = dct16_m[j];
+
+        y0 = _mm_add_ps(y0, _mm_mul_ps(xj, _mm_loadu_ps(m +  0)));
+        y1 = _mm_add_ps(y1, _mm_mul_ps(xj, _mm_loadu_ps(m +  4)));
+        y2 = _mm_add_ps(y2, _mm_mul_ps(xj, _mm_loadu_ps(m +  8)));
+        y3 = _mm_add_ps(y3, _mm_mul_ps(xj, _mm_loadu_ps(m + 12)));
+    }
+
+    _mm_storeu_ps(y +  0, y0);
+    _mm_storeu_ps(y +  4, y1);
+    _mm_storeu_ps(y +  8, y2);
+    _mm_storeu_ps(y + 12, y3);
+}
+
+#ifndef TEST_SSE
+#define dct16_forward sse_dct16_forward
+#endif
+
+#endif /* dct16_forward */
+
+/**
+ * Inverse DCT-16 transformation
+ * The columns of the matrix are obtained by transposing its 4x4 blocks.
+ */
+#ifndef dct16_inverse
+
+LC3_HOT static void sse_dct16_inverse(const float *x, float *y)
+{
+    for (int i = 0; i < 16; i += 4) {
+        __m128 yi = _mm_setzero_ps();
+
+        for (int j = 0; j < 16; j += 4) {
+            __m128 m0 = _mm_loadu_ps(dct16_m[i+0] + j);
+            __m128 m1 = _mm_loadu_ps(dct16_m[i+1] + j);
+            __m128 m2 = _mm_loadu_ps(dct16_m[i+2] + j);
+            __m128 m3 = _mm_loadu_ps(dct16_m[i+3] + j);
+
+            _MM_TRANSPOSE4_PS(m0, m1, m2, m3);
+
+            yi = _mm_add_ps(yi, _mm_mul_ps(_mm_set1_ps(x[j+0]), m0));
+            yi = _mm_add_ps(yi, _mm_mul_ps(_mm_set1_ps(x[j+1]), m1));
+            yi = _mm_add_ps(yi, _mm_mul_ps(_mm_set1_ps(x[j+2]), m2));
+            yi = _mm_add_ps(yi, _mm_mul_ps(_mm_set1_ps(x[j+3]), m3));
+        }
+
+        _mm_storeu_ps(y + i, yi);
+    }
+}
+
+#ifndef TEST_SSE
+#define dct16_inverse sse_dct16_inverse
+#endif
+
+#endif /* dct16_inverse */
+
+
+/* ----------------------------------------------------------------------------
+ *  Quantization
+ * -------------------------------------------------------------------------- */
+
+/**
+ * Codebooks
+ * The distances to 4 entries of a codebook are summed at once
+ * by horizontal additions. As the scalar version, the first of
+ * the closest entries is selected.
+ */
+#ifndef resolve_codebooks
+
+LC3_HOT static int sse_resolve_codebook(
+    const float *scf, const float (*cb)[8])
+{
+    __m128 s0 = _mm_loadu_ps(scf + 0);
+    __m128 s1 = _mm_loadu_ps(scf + 4);
+
+    __m128 dmin = _mm_set1_ps(INFINITY);
+    __m128i imin = _mm_setzero_si128();
+
+    for (int icb = 0; icb < 32; icb += 4) {
+        __m128 d[4];
+
+        for (int k = 0; k < 4; k++) {
+            __m128 r0 = _mm_sub_ps(s0, _mm_loadu_ps(cb[icb+k] + 0));
+            __m128 r1 = _mm_sub_ps(s1, _mm_loadu_ps(cb[icb+k] + 4));
+            d[k] = _mm_add_ps(_mm_mul_ps(r0, r0), _mm_mul_ps(r1, r1));
+        }
+
+        __m128 dk = _mm_hadd_ps(
+            _mm_hadd_ps(d[0], d[1]), _mm_hadd_ps(d[2], d[3]));
+
+        __m128 lt = _mm_cmplt_ps(dk, dmin);
+        dmin = _mm_blendv_ps(dmin, dk, lt);
+        imin = _mm_blendv_epi8(imin,
+            _mm_add_epi32(_mm_set1_epi32(icb), _mm_setr_epi32(0, 1, 2, 3)),
+            _mm_castps_si128(lt));
+    }
+
+    float unused;
+    return sse_argmin_ps(dmin, imin, &unused);
+}
+
+LC3_HOT static void sse_resolve_codebooks(
+    const float *scf, int *lfcb_idx, int *hfcb_idx)
+{
+    *lfcb_idx = sse_resolve_codebook(scf + 0, lc3_sns_lfcb);
+    *hfcb_idx = sse_resolve_codebook(scf + 8, lc3_sns_hfcb);
+}
+
+#ifndef TEST_SSE
+#define resolve_codebooks sse_resolve_codebooks
+#endif
+
+#endif /* resolve_codebooks */
+
+/**
+ * Selection of the shape and gain
+ * The 18 combinations, of 2, 4, 4 and 8 gains for the shapes 0 to 3,
+ * are evaluated at once in 5 vectors, in the order of the scalar search.
+ * The index `8 * shape + gain` of the first of the minimum errors
+ * is then selected, as the scalar version.
+ */
+#ifndef search_shape_gain
+
+LC3_HOT static void sse_search_shape_gain(const float *x,
+    float (*cn)[16], int *shape_idx, int *gain_idx)
+{
+    const struct lc3_sns_vq_gains *gains = lc3_sns_vq_gains;
+
+    __m128 g0 = _mm_castpd_ps(_mm_load_sd((const double *)gains[0].v));
+    __m128 g1 = _mm_loadu_ps(gains[1].v);
+    __m128 g2 = _mm_loadu_ps(gains[2].v);
+    __m128 g3 = _mm_loadu_ps(gains[3].v + 0);
+    __m128 g4 = _mm_loadu_ps(gains[3].v + 4);
+
+    __m128 m0 = _mm_setzero_ps(), m1 = _mm_setzero_ps();
+    __m128 m2 = _mm_setzero_ps(), m3 = _mm_setzero_ps();
+    __m128 m4 = _mm_setzero_ps();
+
+    for (int i = 0; i < 16; i++) {
+        __m128 xi = _mm_set1_ps(x[i]), e;
+
+        e = _mm_sub_ps(xi, _mm_mul_ps(g0, _mm_set1_ps(cn[0][i])));
+        m0 = _mm_add_ps(m0, _mm_mul_ps(e, e));
+
+        e = _mm_sub_ps(xi, _mm_mul_ps(g1, _mm_set1_ps(cn[1][i])));
+        m1 = _mm_add_ps(m1, _mm_mul_ps(e, e));
+
+        e = _mm_sub_ps(xi, _mm_mul_ps(g2, _mm_set1_ps(cn[2][i])));
+        m2 = _mm_add_ps(m2, _mm_mul_ps(e, e));
+
+        __m128 c3 = _mm_set1_ps(cn[3][i]);
+
+        e = _mm_sub_ps(xi, _mm_mul_ps(g3, c3));
+        m3 = _mm_add_ps(m3, _mm_mul_ps(e, e));
+
+        e = _mm_sub_ps(xi, _mm_mul_ps(g4, c3));
+        m4 = _mm_add_ps(m4, _mm_mul_ps(e, e));
+    }
+
+    m0 = _mm_blend_ps(m0, _mm_set1_ps(INFINITY), 0xc);
+
+    __m128 lt, mmin = m0;
+    __m128i imin = _mm_setr_epi32(0, 1, 2, 3);
+
+#define SSE_SEARCH_SHAPE_GAIN_MIN(m, idx) \
+    lt = _mm_cmplt_ps(m, mmin); \
+    mmin = _mm_blendv_ps(mmin, m, lt); \
+    imin = _mm_blendv_epi8(imin, idx, _mm_castps_si128(lt))
+
+    SSE_SEARCH_SHAPE_GAIN_MIN(m1, _mm_setr_epi32( 8,  9, 10, 11));
+    SSE_SEARCH_SHAPE_GAIN_MIN(m2, _mm_setr_epi32(16, 17, 18, 19));
+    SSE_SEARCH_SHAPE_GAIN_MIN(m3, _mm_setr_epi32(24, 25, 26, 27));
+    SSE_SEARCH_SHAPE_GAIN_MIN(m4, _mm_setr_epi32(28, 29, 30, 31));
+
+#undef SSE_SEARCH_SHAPE_GAIN_MIN
+
+    float unused;
+    int idx = sse_argmin_ps(mmin, imin, &unused);
+
+    *shape_idx = idx >> 3;
+    *gain_idx = idx & 7;
+}
+
+#ifndef TEST_SSE
+#define search_shape_gain sse_search_shape_gain
+#endif
+
+#endif /* search_shape_gain */
+
+
+#endif /* __SSE4_1__ && !TEST_NEON || TEST_SSE */
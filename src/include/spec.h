@@ -51,6 +51,7 @@ typedef struct lc3_spec_side {
  * Spectrum analysis
  * dt, sr, nbytes  Duration, samplerate and size of the frame
  * pitch, tns      Pitch present indication and TNS bistream data
+ * adjust          Adjust the global gain, after a first quantization
  * spec            Context of analysis
  * x               Spectral coefficients, scaled as output
  * xq, side        Return quantization data
@@ -60,7 +61,7 @@ typedef struct lc3_spec_side {
  *   b15..b1  Absolute value
  */
 void lc3_spec_analyze(enum lc3_dt dt, enum lc3_srate sr,
-    int nbytes, bool pitch, const lc3_tns_data_t *tns,
+    int nbytes, bool pitch, const lc3_tns_data_t *tns, bool adjust,
     lc3_spec_analysis_t *spec, float *x, uint16_t *xq, lc3_spec_side_t *side);
 
 /**
@@ -103,6 +104,19 @@ void lc3_spec_encode(lc3_bits_t *bits,
 int lc3_spec_get_side(lc3_bits_t *bits,
     enum lc3_dt dt, enum lc3_srate sr, lc3_spec_side_t *side);
 
+/**
+ * Parse spectral coefficients, without unquantization nor noise filling
+ * bits            Bitstream context
+ * dt, sr, nbytes  Duration, samplerate and size of the frame
+ * side            Quantization side data
+ * x               Return the quantized coefficients
+ * nf              Return the noise factor
+ * return          0: Ok  -1: Invalid bitstream data
+ */
+int lc3_spec_parse(lc3_bits_t *bits,
+    enum lc3_dt dt, enum lc3_srate sr, int nbytes,
+    const lc3_spec_side_t *side, float *x, int *nf);
+
 /**
  * Decode spectral coefficients
  * bits            Bitstream context
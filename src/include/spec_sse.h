@@ -0,0 +1,321 @@
+/******************************************************************************
+ *
+ *  Copyright 2022 Google LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#if defined(__SSE4_1__) && !defined(TEST_NEON) || defined(TEST_SSE)
+
+#include <immintrin.h>
+
+
+/**
+ * Import
+ */
+
+static float unquantize_gain(int);
+
+
+/* ----------------------------------------------------------------------------
+ *  Helpers
+ * -------------------------------------------------------------------------- */
+
+/**
+ * Return the sum of the 32 bits elements of a vector
+ */
+static inline int32_t sse_hadd_epi32(__m128i v)
+{
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    return _mm_cvtsi128_si32(v);
+}
+
+/**
+ * Fast `10 * log10(x)` (or dB) approximation in fixed Q16, of 4 values
+ * See `fast_db_q16()`, the entries of the table are gathered by AVX2,
+ * and loaded one by one otherwise.
+ */
+static inline __m128i sse_fast_db_q16(__m128 x)
+{
+    __m128i u = _mm_castps_si128(_mm_mul_ps(x, x));
+
+    __m128i e2 = _mm_sub_epi32(_mm_srli_epi32(u, 22), _mm_set1_epi32(2*127));
+    __m128i hi = _mm_and_si128(_mm_srli_epi32(u, 18), _mm_set1_epi32(0x1f));
+    __m128i lo = _mm_and_si128(_mm_srli_epi32(u,  2), _mm_set1_epi32(0xffff));
+
+#ifdef __AVX2__
+    __m128i t = _mm_i32gather_epi32(
+        (const int *)fast_db_q16_table, hi, sizeof(*fast_db_q16_table));
+#else
+    const uint16_t (*tp)[2] = fast_db_q16_table;
+    int h0 = _mm_extract_epi32(hi, 0), h1 = _mm_extract_epi32(hi, 1);
+    int h2 = _mm_extract_epi32(hi, 2), h3 = _mm_extract_epi32(hi, 3);
+
+    __m128i t = _mm_setr_epi32(
+        tp[h0][0] | tp[h0][1] << 16, tp[h1][0] | tp[h1][1] << 16,
+        tp[h2][0] | tp[h2][1] << 16, tp[h3][0] | tp[h3][1] << 16 );
+#endif
+
+    __m128i t0 = _mm_and_si128(t, _mm_set1_epi32(0xffff));
+    __m128i t1 = _mm_srli_epi32(t, 16);
+
+    return _mm_add_epi32(
+        _mm_add_epi32(_mm_mullo_epi32(e2, _mm_set1_epi32(49321)), t0),
+        _mm_srli_epi32(_mm_mullo_epi32(t1, lo), 16) );
+}
+
+
+/* ----------------------------------------------------------------------------
+ *  Global Gain / Quantization
+ * -------------------------------------------------------------------------- */
+
+/**
+ * Energy (dB) by blocks of 4 MDCT coefficients
+ *
+ * 4 blocks are processed by iteration, the squares are transposed
+ * so that each vector holds a coefficient of the 4 blocks.
+ */
+#ifndef compute_energy_db
+
+LC3_HOT static float sse_compute_energy_db(const float *x, int n, int *e)
+{
+    __m128 x2_max = _mm_setzero_ps();
+    int i = 0;
+
+    for ( ; i + 4 <= n; i += 4, x += 16) {
+        __m128 x0 = _mm_loadu_ps(x +  0);
+        __m128 x1 = _mm_loadu_ps(x +  4);
+        __m128 x2 = _mm_loadu_ps(x +  8);
+        __m128 x3 = _mm_loadu_ps(x + 12);
+
+        x0 = _mm_mul_ps(x0, x0);
+        x1 = _mm_mul_ps(x1, x1);
+        x2 = _mm_mul_ps(x2, x2);
+        x3 = _mm_mul_ps(x3, x3);
+
+        x2_max = _mm_max_ps(x2_max,
+            _mm_max_ps(_mm_max_ps(x0, x1), _mm_max_ps(x2, x3)));
+
+        _MM_TRANSPOSE4_PS(x0, x1, x2, x3);
+
+        __m128 s = _mm_add_ps(_mm_add_ps(_mm_add_ps(x0, x1), x2), x3);
+        s = _mm_max_ps(s, _mm_set1_ps(1e-10f));
+
+        _mm_storeu_si128((__m128i *)(e + i), sse_fast_db_q16(s));
+    }
+
+    x2_max = _mm_max_ps(x2_max, _mm_movehl_ps(x2_max, x2_max));
+    x2_max = _mm_max_ss(x2_max, _mm_shuffle_ps(x2_max, x2_max, 1));
+
+    float x2_max_s = _mm_cvtss_f32(x2_max);
+
+    for ( ; i < n; i++, x += 4) {
+        float x0 = x[0] * x[0];
+        float x1 = x[1] * x[1];
+        float x2 = x[2] * x[2];
+        float x3 = x[3] * x[3];
+
+        x2_max_s = fmaxf(x2_max_s, fmaxf(fmaxf(x0, x1), fmaxf(x2, x3)));
+
+        e[i] = fast_db_q16(fmaxf(x0 + x1 + x2 + x3, 1e-10f));
+    }
+
+    return x2_max_s;
+}
+
+#ifndef TEST_SSE
+#define compute_energy_db sse_compute_energy_db
+#endif
+
+#endif /* compute_energy_db */
+
+/**
+ * Cost in bits of the energies, for a gain
+ *
+ * The cost of 4 energies is evaluated by iteration, the 3 cases of the
+ * difference with the gain being computed then selected by blending.
+ */
+#ifndef compute_gain_cost
+
+LC3_HOT static int sse_compute_gain_cost(const int *e, int n, int gn)
+{
+    const int k_2u7 = 2.7f * 0x1p16f + 0.5f;
+
+    const __m128i g = _mm_set1_epi32(gn);
+    const __m128i c_2u7 = _mm_set1_epi32(k_2u7);
+    const __m128i c_7 = _mm_set1_epi32(7 << 16);
+    const __m128i c_36 = _mm_set1_epi32(36 << 16);
+    const __m128i c_43 = _mm_set1_epi32((43 << 16) - 1);
+
+    __m128i v = _mm_setzero_si128();
+    int j = 0;
+
+    for ( ; j + 4 <= n; j += 4) {
+        __m128i d = _mm_sub_epi32(_mm_loadu_si128((const __m128i *)(e + j)), g);
+
+        __m128i c = _mm_blendv_epi8(
+            _mm_add_epi32(d, c_7),
+            _mm_sub_epi32(_mm_add_epi32(d, d), c_36),
+            _mm_cmpgt_epi32(d, c_43) );
+
+        c = _mm_blendv_epi8(c, c_2u7, _mm_cmplt_epi32(d, _mm_setzero_si128()));
+
+        v = _mm_add_epi32(v, c);
+    }
+
+    int v_s = sse_hadd_epi32(v);
+
+    for ( ; j < n; j++) {
+        int e_diff = e[j] - gn;
+
+        v_s += e_diff < 0 ? k_2u7 :
+               e_diff < 43 << 16 ?   e_diff + ( 7 << 16)
+                                 : 2*e_diff - (36 << 16);
+    }
+
+    return v_s;
+}
+
+#ifndef TEST_SSE
+#define compute_gain_cost sse_compute_gain_cost
+#endif
+
+#endif /* compute_gain_cost */
+
+/**
+ * Spectrum quantization
+ *
+ * 8 coefficients are processed by iteration, and packed on 16 bits.
+ * The count of significant coefficients is located by vector, and then
+ * refined by pair.
+ */
+#ifndef quantize
+
+LC3_HOT static void sse_quantize(enum lc3_dt dt, enum lc3_srate sr,
+    int g_int, float *x, uint16_t *xq, int *nq)
+{
+    float g_inv = 1 / unquantize_gain(g_int);
+    int ne = LC3_NE(dt, sr);
+
+    const __m128 g = _mm_set1_ps(g_inv);
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(INT32_MAX));
+    const __m128 offset = _mm_set1_ps(6.f/16);
+    const __m128 q_max = _mm_set1_ps(INT16_MAX);
+
+    int i = 0, n = 0;
+
+    for ( ; i + 8 <= ne; i += 8) {
+        __m128 x0 = _mm_mul_ps(_mm_loadu_ps(x + i    ), g);
+        __m128 x1 = _mm_mul_ps(_mm_loadu_ps(x + i + 4), g);
+
+        _mm_storeu_ps(x + i    , x0);
+        _mm_storeu_ps(x + i + 4, x1);
+
+        __m128i q = _mm_packs_epi32(
+            _mm_cvttps_epi32(_mm_min_ps(
+                _mm_add_ps(_mm_and_ps(x0, abs_mask), offset), q_max)),
+            _mm_cvttps_epi32(_mm_min_ps(
+                _mm_add_ps(_mm_and_ps(x1, abs_mask), offset), q_max)) );
+
+        __m128i s = _mm_packs_epi32(
+            _mm_castps_si128(_mm_cmplt_ps(x0, _mm_setzero_ps())),
+            _mm_castps_si128(_mm_cmplt_ps(x1, _mm_setzero_ps())) );
+
+        __m128i nz = _mm_cmpgt_epi16(q, _mm_setzero_si128());
+
+        _mm_storeu_si128((__m128i *)(xq + i), _mm_sub_epi16(
+            _mm_slli_epi16(q, 1), _mm_and_si128(s, nz) ));
+
+        if (_mm_movemask_epi8(nz))
+            n = i + 8;
+    }
+
+    for ( ; i < ne; i += 2) {
+        uint16_t x0, x1;
+
+        x[i+0] *= g_inv;
+        x[i+1] *= g_inv;
+
+        x0 = fminf(fabsf(x[i+0]) + 6.f/16, INT16_MAX);
+        x1 = fminf(fabsf(x[i+1]) + 6.f/16, INT16_MAX);
+
+        xq[i+0] = (x0 << 1) + ((x0 > 0) & (x[i+0] < 0));
+        xq[i+1] = (x1 << 1) + ((x1 > 0) & (x[i+1] < 0));
+
+        n = x0 || x1 ? i + 2 : n;
+    }
+
+    while (n > 0 && !xq[n-2] && !xq[n-1])
+        n -= 2;
+
+    *nq = n;
+}
+
+#ifndef TEST_SSE
+#define quantize sse_quantize
+#endif
+
+#endif /* quantize */
+
+
+/* ----------------------------------------------------------------------------
+ *  Spectrum coding
+ * -------------------------------------------------------------------------- */
+
+/**
+ * Locate the identical tail of 2 sets of quantized coefficients
+ *
+ * The coefficients are compared by 16 with AVX2, by 8 otherwise,
+ * and then by pair.
+ */
+#ifndef locate_common_tail
+
+LC3_HOT static int sse_locate_common_tail(
+    const uint16_t *x, const uint16_t *y, int n)
+{
+#ifdef __AVX2__
+    for ( ; n >= 16; n -= 16) {
+        __m256i d = _mm256_xor_si256(
+            _mm256_loadu_si256((const __m256i *)(x + n - 16)),
+            _mm256_loadu_si256((const __m256i *)(y + n - 16)) );
+
+        if (!_mm256_testz_si256(d, d))
+            break;
+    }
+#endif
+
+    for ( ; n >= 8; n -= 8) {
+        __m128i d = _mm_xor_si128(
+            _mm_loadu_si128((const __m128i *)(x + n - 8)),
+            _mm_loadu_si128((const __m128i *)(y + n - 8)) );
+
+        if (!_mm_testz_si128(d, d))
+            break;
+    }
+
+    while (n > 0 && x[n-2] == y[n-2] && x[n-1] == y[n-1])
+        n -= 2;
+
+    return n;
+}
+
+#ifndef TEST_SSE
+#define locate_common_tail sse_locate_common_tail
+#endif
+
+#endif /* locate_common_tail */
+
+#endif /* __SSE4_1__ */
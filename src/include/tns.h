@@ -49,7 +49,8 @@ typedef struct lc3_tns_data {
 /**
  * TNS analysis
  * dt, bw          Duration and bandwidth of the frame
- * nn_flag         True when high energy detected near Nyquist frequency
+ * nn_flag         True when high energy detected near Nyquist frequency,
+ *                 the filtering is then disabled
  * nbytes          Size in bytes of the frame
  * data            Return bitstream data
  * x               Spectral coefficients, filtered as output
@@ -64,6 +65,16 @@ void lc3_tns_analyze(enum lc3_dt dt, enum lc3_bandwidth bw,
  */
 int lc3_tns_get_nbits(const lc3_tns_data_t *data);
 
+/**
+ * Adapt bitstream data to a size of frame
+ * dt, nbytes      Duration and size of the frame
+ * data            Bitstream data, its coding set accordingly to `nbytes`
+ *
+ * The filters are kept, only the coding of their order, which depends
+ * on the size of the frame, is changed.
+ */
+void lc3_tns_set_nbytes(enum lc3_dt dt, int nbytes, lc3_tns_data_t *data);
+
 /**
  * Put bitstream data
  * bits            Bitstream context
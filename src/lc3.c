@@ -30,6 +30,8 @@
 #include "tns.h"
 #include "spec.h"
 #include "plc.h"
+#include "cpu.h"
+#include "profile.h"
 
 
 /**
@@ -45,6 +47,25 @@ struct side_data {
     lc3_spec_side_t spec;
 };
 
+/**
+ * Frame encoding data, side data, quantized spectrum,
+ * and intermediate results of the analysis
+ */
+
+struct encode_data {
+    struct side_data side;
+    uint16_t xq[LC3_MAX_NE];
+
+    bool att, nn_flag;
+    float e[LC3_NUM_BANDS];
+};
+
+/**
+ * Number of frames processed together by the batch interface
+ */
+
+#define LC3_BATCH_SIZE  8
+
 
 /* ----------------------------------------------------------------------------
  *  General
@@ -65,14 +86,31 @@ static enum lc3_dt resolve_dt(int us)
  * Resolve samplerate in Hz
  * hz              Samplerate in Hz
  * return          Sample rate identifier, or LC3_NUM_SRATE
+ *
+ * The 44.1 KHz samplerate is coded with the configuration of 48 KHz,
+ * the frames then last 8.163 ms or 10.884 ms.
  */
 static enum lc3_srate resolve_sr(int hz)
 {
     return hz ==  8000 ? LC3_SRATE_8K  : hz == 16000 ? LC3_SRATE_16K :
            hz == 24000 ? LC3_SRATE_24K : hz == 32000 ? LC3_SRATE_32K :
+           hz == 44100 ? LC3_SRATE_48K :
            hz == 48000 ? LC3_SRATE_48K : LC3_NUM_SRATE;
 }
 
+/**
+ * Check that two samplerates can be converted by the codec
+ * hz, pcm_hz      Samplerates of the stream and of the PCM samples
+ * return          True when both or none are the 44.1 KHz samplerate
+ *
+ * The stream is not resampled from 44.1 KHz to the other samplerates,
+ * only the bandwidth is changed.
+ */
+static bool check_sr_pair(int hz, int pcm_hz)
+{
+    return (hz == 44100) == (pcm_hz == 44100);
+}
+
 /**
  * Return the number of PCM samples in a frame
  */
@@ -92,7 +130,18 @@ int lc3_frame_samples(int dt_us, int sr_hz)
  */
 int lc3_frame_bytes(int dt_us, int bitrate)
 {
-    if (resolve_dt(dt_us) >= LC3_NUM_DT)
+    return lc3_frame_bytes_ex(dt_us, 48000, bitrate);
+}
+
+/**
+ * Return the size of frames, from bitrate and samplerate
+ */
+int lc3_frame_bytes_ex(int dt_us, int sr_hz, int bitrate)
+{
+    enum lc3_dt dt = resolve_dt(dt_us);
+    enum lc3_srate sr = resolve_sr(sr_hz);
+
+    if (dt >= LC3_NUM_DT || sr >= LC3_NUM_SRATE)
         return -1;
 
     if (bitrate < LC3_MIN_BITRATE)
@@ -101,7 +150,11 @@ int lc3_frame_bytes(int dt_us, int bitrate)
     if (bitrate > LC3_MAX_BITRATE)
         return LC3_MAX_FRAME_BYTES;
 
-    int nbytes = ((unsigned)bitrate * dt_us) / (1000*1000*8);
+    /* The duration of the frames is `ns / sr_hz`,
+     * which differs from `dt_us` at 44.1 KHz */
+
+    int ns = LC3_NS(dt, sr);
+    int nbytes = ((unsigned)bitrate * ns) / (8 * (unsigned)sr_hz);
 
     return LC3_CLIP(nbytes, LC3_MIN_FRAME_BYTES, LC3_MAX_FRAME_BYTES);
 }
@@ -111,7 +164,18 @@ int lc3_frame_bytes(int dt_us, int bitrate)
  */
 int lc3_resolve_bitrate(int dt_us, int nbytes)
 {
-    if (resolve_dt(dt_us) >= LC3_NUM_DT)
+    return lc3_resolve_bitrate_ex(dt_us, 48000, nbytes);
+}
+
+/**
+ * Resolve the bitrate, from the size of frames and samplerate
+ */
+int lc3_resolve_bitrate_ex(int dt_us, int sr_hz, int nbytes)
+{
+    enum lc3_dt dt = resolve_dt(dt_us);
+    enum lc3_srate sr = resolve_sr(sr_hz);
+
+    if (dt >= LC3_NUM_DT || sr >= LC3_NUM_SRATE)
         return -1;
 
     if (nbytes < LC3_MIN_FRAME_BYTES)
@@ -120,7 +184,8 @@ int lc3_resolve_bitrate(int dt_us, int nbytes)
     if (nbytes > LC3_MAX_FRAME_BYTES)
         return LC3_MAX_BITRATE;
 
-    int bitrate = ((unsigned)nbytes * (1000*1000*8) + dt_us/2) / dt_us;
+    int ns = LC3_NS(dt, sr);
+    int bitrate = ((unsigned)nbytes * 8 * sr_hz + ns/2) / ns;
 
     return LC3_CLIP(bitrate, LC3_MIN_BITRATE, LC3_MAX_BITRATE);
 }
@@ -238,54 +303,178 @@ static void load_float(
     }
 }
 
+/**
+ * Spectral flatness test, gating TNS analysis on reduced complexity
+ * dt, sr          Duration and samplerate of the frame
+ * e               Energy estimation per bands
+ * return          True when the spectrum is flat enough to run TNS
+ *
+ * The flatness is the ratio of the geometric mean by the arithmetic mean
+ * of the energies of the bands. The frames where the TNS filters are
+ * enabled, are mostly the flattest, above 1/64 (-18 dB).
+ *
+ * The logarithms are approximated by the IEEE-754 representation of the
+ * floats, the exponent and the mantissa read as a fixed Q23 value.
+ */
+static bool flat_spectrum(enum lc3_dt dt, enum lc3_srate sr, const float *e)
+{
+    int nb = LC3_MIN(LC3_NUM_BANDS, LC3_NS(dt, sr));
+    union { float f; int32_t q23; } v;
+    int64_t log2_sum = 0;
+    float sum = 0;
+
+    for (int i = 0; i < nb; i++) {
+        v.f = e[i] + 1;
+        log2_sum += v.q23;
+        sum += e[i];
+    }
+
+    v.f = sum / nb + 1;
+
+    return log2_sum / nb - v.q23 > -(6 << 23);
+}
+
 /**
  * Frame Analysis
- * encoder         Encoder state
- * nbytes          Size in bytes of the frame
- * side, xq        Return frame data
+ * encoders, n     Encoder states, of the same configuration, and count
+ * nbytes          Size in bytes of the frames
+ * data            Return the frames data
+ *
+ * The frames are processed together, stage by stage.
  */
-static void analyze(struct lc3_encoder *encoder,
-    int nbytes, struct side_data *side, uint16_t *xq)
+static void analyze(struct lc3_encoder * const *encoders, int n,
+    const int *nbytes, struct encode_data *data)
 {
-    enum lc3_dt dt = encoder->dt;
-    enum lc3_srate sr = encoder->sr;
-    enum lc3_srate sr_pcm = encoder->sr_pcm;
+    enum lc3_dt dt = encoders[0]->dt;
+    enum lc3_srate sr = encoders[0]->sr;
+    enum lc3_srate sr_pcm = encoders[0]->sr_pcm;
     int ns = LC3_NS(dt, sr_pcm);
     int nt = LC3_NT(sr_pcm);
 
-    int16_t *xt = (int16_t *)encoder->x + encoder->xt_off;
-    float *xs = encoder->x + encoder->xs_off;
-    float *xd = encoder->x + encoder->xd_off;
-    float *xf = xs;
-
     /* --- Temporal --- */
 
-    bool att = lc3_attdet_run(dt, sr_pcm, nbytes, &encoder->attdet, xt);
+    for (int i = 0; i < n; i++) {
+        struct lc3_encoder *encoder = encoders[i];
+        int16_t *xt = (int16_t *)encoder->x + encoder->xt_off;
+        LC3_PROFILE_BEGIN(t);
+
+        data[i].att = encoder->cpu->attdet_run(
+            dt, sr_pcm, nbytes[i], &encoder->attdet, xt);
 
-    side->pitch_present =
-        lc3_ltpf_analyse(dt, sr_pcm, &encoder->ltpf, xt, &side->ltpf);
+        LC3_PROFILE_END(t, encoder->stats.cycles[LC3_ENCODER_STAGE_ATTDET]);
+    }
+
+    for (int i = 0; i < n; i++) {
+        struct lc3_encoder *encoder = encoders[i];
+        struct side_data *side = &data[i].side;
+        int16_t *xt = (int16_t *)encoder->x + encoder->xt_off;
+        LC3_PROFILE_BEGIN(t);
+
+        side->pitch_present = encoder->cpu->ltpf_analyse(
+            dt, sr_pcm, encoder->complexity >= LC3_COMPLEXITY_MEDIUM,
+            &encoder->ltpf, xt, &side->ltpf);
 
-    memmove(xt - nt, xt + (ns-nt), nt * sizeof(*xt));
+        memmove(xt - nt, xt + (ns-nt), nt * sizeof(*xt));
+
+        LC3_PROFILE_END(t, encoder->stats.cycles[LC3_ENCODER_STAGE_LTPF]);
+    }
 
     /* --- Spectral --- */
 
-    float e[LC3_NUM_BANDS];
+    for (int i = 0; i < n; i++) {
+        struct lc3_encoder *encoder = encoders[i];
+        float *xs = encoder->x + encoder->xs_off;
+        float *xd = encoder->x + encoder->xd_off;
+        LC3_PROFILE_BEGIN(t);
 
-    lc3_mdct_forward(dt, sr_pcm, sr, xs, xd, xf);
+        encoder->cpu->mdct_forward(dt, sr_pcm, sr, xs, xd, xs);
 
-    bool nn_flag = lc3_energy_compute(dt, sr, xf, e);
-    if (nn_flag)
-        lc3_ltpf_disable(&side->ltpf);
+        LC3_PROFILE_END(t, encoder->stats.cycles[LC3_ENCODER_STAGE_MDCT]);
+    }
+
+    for (int i = 0; i < n; i++) {
+        struct lc3_encoder *encoder = encoders[i];
+        float *xf = encoder->x + encoder->xs_off;
+        LC3_PROFILE_BEGIN(t);
+
+        data[i].nn_flag = lc3_energy_compute(dt, sr, xf, data[i].e);
+        if (data[i].nn_flag)
+            lc3_ltpf_disable(&data[i].side.ltpf);
 
-    side->bw = lc3_bwdet_run(dt, sr, e);
+        LC3_PROFILE_END(t, encoder->stats.cycles[LC3_ENCODER_STAGE_ENERGY]);
+    }
+
+    for (int i = 0; i < n; i++) {
+        LC3_PROFILE_BEGIN(t);
 
-    lc3_sns_analyze(dt, sr, e, att, &side->sns, xf, xf);
+        data[i].side.bw = lc3_bwdet_run(dt, sr, data[i].e);
 
-    lc3_tns_analyze(dt, side->bw, nn_flag, nbytes, &side->tns, xf);
+        LC3_PROFILE_END(t, encoders[i]->stats.cycles[LC3_ENCODER_STAGE_BWDET]);
+    }
 
-    lc3_spec_analyze(dt, sr,
-        nbytes, side->pitch_present, &side->tns,
-        &encoder->spec, xf, xq, &side->spec);
+    for (int i = 0; i < n; i++) {
+        struct lc3_encoder *encoder = encoders[i];
+        float *xf = encoder->x + encoder->xs_off;
+        LC3_PROFILE_BEGIN(t);
+
+        encoder->cpu->sns_analyze(dt, sr,
+            data[i].e, data[i].att, &data[i].side.sns, xf, xf);
+
+        LC3_PROFILE_END(t, encoder->stats.cycles[LC3_ENCODER_STAGE_SNS]);
+    }
+
+    for (int i = 0; i < n; i++) {
+        struct lc3_encoder *encoder = encoders[i];
+        struct side_data *side = &data[i].side;
+        float *xf = encoder->x + encoder->xs_off;
+        LC3_PROFILE_BEGIN(t);
+
+        bool tns_off = data[i].nn_flag ||
+            (encoder->complexity >= LC3_COMPLEXITY_MEDIUM &&
+             !flat_spectrum(dt, sr, data[i].e));
+
+        encoder->cpu->tns_analyze(dt,
+            side->bw, tns_off, nbytes[i], &side->tns, xf);
+
+        LC3_PROFILE_END(t, encoder->stats.cycles[LC3_ENCODER_STAGE_TNS]);
+    }
+
+    for (int i = 0; i < n; i++) {
+        struct lc3_encoder *encoder = encoders[i];
+        struct side_data *side = &data[i].side;
+        float *xf = encoder->x + encoder->xs_off;
+        LC3_PROFILE_BEGIN(t);
+
+        encoder->cpu->spec_analyze(dt, sr,
+            nbytes[i], side->pitch_present, &side->tns,
+            encoder->complexity < LC3_COMPLEXITY_LOW,
+            &encoder->spec, xf, data[i].xq, &side->spec);
+
+        LC3_PROFILE_END(t, encoder->stats.cycles[LC3_ENCODER_STAGE_SPEC]);
+    }
+}
+
+/**
+ * Put the side data of a frame
+ * bits            Bitstream context
+ * dt, sr          Duration and samplerate of the frame
+ * side            The side data
+ */
+static void put_side(lc3_bits_t *bits,
+    enum lc3_dt dt, enum lc3_srate sr, const struct side_data *side)
+{
+    lc3_bwdet_put_bw(bits, sr, side->bw);
+
+    lc3_spec_put_side(bits, dt, sr, &side->spec);
+
+    lc3_tns_put_data(bits, &side->tns);
+
+    lc3_put_bit(bits, side->pitch_present);
+
+    lc3_sns_put_data(bits, &side->sns);
+
+    if (side->pitch_present)
+        lc3_ltpf_put_data(bits, &side->ltpf);
 }
 
 /**
@@ -304,26 +493,48 @@ static void encode(struct lc3_encoder *encoder,
     float *xf = encoder->x + encoder->xs_off;
 
     lc3_bits_t bits;
+    LC3_PROFILE_BEGIN(t);
 
     lc3_setup_bits(&bits, LC3_BITS_MODE_WRITE, buffer, nbytes);
 
-    lc3_bwdet_put_bw(&bits, sr, bw);
+    put_side(&bits, dt, sr, side);
 
-    lc3_spec_put_side(&bits, dt, sr, &side->spec);
+    lc3_spec_encode(&bits,
+        dt, sr, bw, nbytes, xq, &side->spec, xf);
 
-    lc3_tns_put_data(&bits, &side->tns);
+    lc3_flush_bits(&bits);
 
-    lc3_put_bit(&bits, side->pitch_present);
+    LC3_PROFILE_END(t, encoder->stats.cycles[LC3_ENCODER_STAGE_ENCODE]);
 
-    lc3_sns_put_data(&bits, &side->sns);
+    LC3_PROFILE_COUNT(encoder->stats.frames, 1);
+    LC3_PROFILE_COUNT(encoder->stats.ltpf_active,
+        side->pitch_present && side->ltpf.active);
+    LC3_PROFILE_COUNT(encoder->stats.tns_filters[0],
+        side->tns.nfilters > 0 && side->tns.rc_order[0] > 0);
+    LC3_PROFILE_COUNT(encoder->stats.tns_filters[1],
+        side->tns.nfilters > 1 && side->tns.rc_order[1] > 0);
+}
 
-    if (side->pitch_present)
-        lc3_ltpf_put_data(&bits, &side->ltpf);
+/**
+ * Return the statistics of an encoder
+ */
+int lc3_encoder_stats(
+    struct lc3_encoder *encoder, struct lc3_encoder_stats *stats)
+{
+    if (!stats)
+        return -1;
 
-    lc3_spec_encode(&bits,
-        dt, sr, bw, nbytes, xq, &side->spec, xf);
+#ifdef LC3_PROFILE
+    if (encoder) {
+        *stats = encoder->stats;
+        return 0;
+    }
+#else
+    (void)encoder;
+#endif
 
-    lc3_flush_bits(&bits);
+    *stats = (struct lc3_encoder_stats){ 0 };
+    return -1;
 }
 
 /**
@@ -344,6 +555,16 @@ unsigned lc3_encoder_size(int dt_us, int sr_hz)
  */
 struct lc3_encoder *lc3_setup_encoder(
     int dt_us, int sr_hz, int sr_pcm_hz, void *mem)
+{
+    return lc3_setup_encoder_ex(
+        dt_us, sr_hz, sr_pcm_hz, LC3_COMPLEXITY_HIGH, mem);
+}
+
+/**
+ * Setup encoder, with a complexity level
+ */
+struct lc3_encoder *lc3_setup_encoder_ex(int dt_us, int sr_hz, int sr_pcm_hz,
+    enum lc3_complexity complexity, void *mem)
 {
     if (sr_pcm_hz <= 0)
         sr_pcm_hz = sr_hz;
@@ -352,7 +573,9 @@ struct lc3_encoder *lc3_setup_encoder(
     enum lc3_srate sr = resolve_sr(sr_hz);
     enum lc3_srate sr_pcm = resolve_sr(sr_pcm_hz);
 
-    if (dt >= LC3_NUM_DT || sr_pcm >= LC3_NUM_SRATE || sr > sr_pcm || !mem)
+    if (dt >= LC3_NUM_DT || sr_pcm >= LC3_NUM_SRATE || sr > sr_pcm ||
+            !check_sr_pair(sr_hz, sr_pcm_hz) ||
+            (unsigned)complexity >= LC3_NUM_COMPLEXITY || !mem)
         return NULL;
 
     struct lc3_encoder *encoder = mem;
@@ -362,6 +585,8 @@ struct lc3_encoder *lc3_setup_encoder(
     *encoder = (struct lc3_encoder){
         .dt = dt, .sr = sr,
         .sr_pcm = sr_pcm,
+        .complexity = complexity,
+        .cpu = lc3_cpu_ops(),
 
         .xt_off = nt,
         .xs_off = (nt + ns) / 2,
@@ -374,6 +599,19 @@ struct lc3_encoder *lc3_setup_encoder(
     return encoder;
 }
 
+/**
+ * Change the complexity level of an encoder
+ */
+int lc3_set_encoder_complexity(
+    struct lc3_encoder *encoder, enum lc3_complexity complexity)
+{
+    if (!encoder || (unsigned)complexity >= LC3_NUM_COMPLEXITY)
+        return -1;
+
+    encoder->complexity = complexity;
+    return 0;
+}
+
 /**
  * Encode a frame
  */
@@ -395,14 +633,65 @@ int lc3_encode(struct lc3_encoder *encoder, enum lc3_pcm_format fmt,
 
     /* --- Processing --- */
 
-    struct side_data side;
-    uint16_t xq[LC3_MAX_NE];
+    struct encode_data data;
 
     load[fmt](encoder, pcm, stride);
 
-    analyze(encoder, nbytes, &side, xq);
+    analyze(&encoder, 1, &nbytes, &data);
 
-    encode(encoder, &side, xq, nbytes, out);
+    encode(encoder, &data.side, data.xq, nbytes, out);
+
+    return 0;
+}
+
+/**
+ * Encode a frame of a batch of encoders
+ */
+int lc3_encode_batch(struct lc3_encoder * const *encoders, int n,
+    enum lc3_pcm_format fmt, const void * const *pcm, int stride,
+    const int *nbytes, void * const *out)
+{
+    static void (* const load[])(struct lc3_encoder *, const void *, int) = {
+        [LC3_PCM_FORMAT_S16    ] = load_s16,
+        [LC3_PCM_FORMAT_S24    ] = load_s24,
+        [LC3_PCM_FORMAT_S24_3LE] = load_s24_3le,
+        [LC3_PCM_FORMAT_FLOAT  ] = load_float,
+    };
+
+    /* --- Check parameters --- */
+
+    if (!encoders || n < 0)
+        return -1;
+
+    for (int i = 0; i < n; i++) {
+        const struct lc3_encoder *encoder = encoders[i];
+
+        if (!encoder || nbytes[i] < LC3_MIN_FRAME_BYTES
+                     || nbytes[i] > LC3_MAX_FRAME_BYTES)
+            return -1;
+
+        if (encoder->dt != encoders[0]->dt ||
+            encoder->sr != encoders[0]->sr ||
+            encoder->sr_pcm != encoders[0]->sr_pcm)
+            return -1;
+    }
+
+    /* --- Processing, by chunk of batch size --- */
+
+    struct encode_data data[LC3_BATCH_SIZE];
+
+    for (int i0 = 0; i0 < n; i0 += LC3_BATCH_SIZE) {
+        int nb = LC3_MIN(n - i0, LC3_BATCH_SIZE);
+
+        for (int i = 0; i < nb; i++)
+            load[fmt](encoders[i0+i], pcm[i0+i], stride);
+
+        analyze(encoders + i0, nb, nbytes + i0, data);
+
+        for (int i = 0; i < nb; i++)
+            encode(encoders[i0+i],
+                &data[i].side, data[i].xq, nbytes[i0+i], out[i0+i]);
+    }
 
     return 0;
 }
@@ -506,6 +795,37 @@ static void store_float(
     }
 }
 
+/**
+ * Get the side data of a frame
+ * bits            Bitstream context
+ * dt, sr, nbytes  Duration, samplerate and size of the frame
+ * side            Return the side data
+ * return          0: Ok  < 0: Bitsream error detected
+ */
+static int get_side(lc3_bits_t *bits,
+    enum lc3_dt dt, enum lc3_srate sr, int nbytes, struct side_data *side)
+{
+    int ret = 0;
+
+    if ((ret = lc3_bwdet_get_bw(bits, sr, &side->bw)) < 0)
+        return ret;
+
+    if ((ret = lc3_spec_get_side(bits, dt, sr, &side->spec)) < 0)
+        return ret;
+
+    lc3_tns_get_data(bits, dt, side->bw, nbytes, &side->tns);
+
+    side->pitch_present = lc3_get_bit(bits);
+
+    if ((ret = lc3_sns_get_data(bits, &side->sns)) < 0)
+        return ret;
+
+    if (side->pitch_present)
+        lc3_ltpf_get_data(bits, &side->ltpf);
+
+    return 0;
+}
+
 /**
  * Decode bitstream
  * decoder         Decoder state
@@ -519,7 +839,7 @@ static int decode(struct lc3_decoder *decoder,
     enum lc3_dt dt = decoder->dt;
     enum lc3_srate sr = decoder->sr;
 
-    float *xf = decoder->x + decoder->xs_off;
+    float *xf = decoder->x + decoder->xf_off;
     int ns = LC3_NS(dt, sr);
     int ne = LC3_NE(dt, sr);
 
@@ -528,22 +848,9 @@ static int decode(struct lc3_decoder *decoder,
 
     lc3_setup_bits(&bits, LC3_BITS_MODE_READ, (void *)data, nbytes);
 
-    if ((ret = lc3_bwdet_get_bw(&bits, sr, &side->bw)) < 0)
-        return ret;
-
-    if ((ret = lc3_spec_get_side(&bits, dt, sr, &side->spec)) < 0)
+    if ((ret = get_side(&bits, dt, sr, nbytes, side)) < 0)
         return ret;
 
-    lc3_tns_get_data(&bits, dt, side->bw, nbytes, &side->tns);
-
-    side->pitch_present = lc3_get_bit(&bits);
-
-    if ((ret = lc3_sns_get_data(&bits, &side->sns)) < 0)
-        return ret;
-
-    if (side->pitch_present)
-        lc3_ltpf_get_data(&bits, &side->ltpf);
-
     if ((ret = lc3_spec_decode(&bits, dt, sr,
                     side->bw, nbytes, &side->spec, xf)) < 0)
         return ret;
@@ -554,49 +861,166 @@ static int decode(struct lc3_decoder *decoder,
 }
 
 /**
- * Frame synthesis
+ * Load the history of a compact decoder
  * decoder         Decoder state
- * side            Frame data, NULL performs PLC
- * nbytes          Size in bytes of the frame
+ * x               Return the history as float samples
+ *
+ * The `LC3_NL()` last samples, from the oldest, are loaded.
  */
-static void synthesize(struct lc3_decoder *decoder,
-    const struct side_data *side, int nbytes)
+static void load_history(const struct lc3_decoder *decoder, float *x)
 {
-    enum lc3_dt dt = decoder->dt;
-    enum lc3_srate sr = decoder->sr;
-    enum lc3_srate sr_pcm = decoder->sr_pcm;
+    const int16_t *xl = (const int16_t *)(decoder->x + decoder->xl_off);
+    int nl = LC3_NL(decoder->sr_pcm);
+    int pos = decoder->xl_pos;
+
+    for (int i = pos; i < nl; i++)
+        *(x++) = xl[i];
+
+    for (int i = 0; i < pos; i++)
+        *(x++) = xl[i];
+}
 
-    float *xf = decoder->x + decoder->xs_off;
+/**
+ * Append a frame to the history of a compact decoder
+ * decoder         Decoder state
+ * x, n            Samples of the frame, and count
+ */
+static void store_history(struct lc3_decoder *decoder, const float *x, int n)
+{
+    int16_t *xl = (int16_t *)(decoder->x + decoder->xl_off);
+    int nl = LC3_NL(decoder->sr_pcm);
+    int pos = decoder->xl_pos;
+
+    for ( ; n > 0; n--, x++) {
+        int32_t s = *x >= 0 ? (int)(*x + 0.5f) : (int)(*x - 0.5f);
+        xl[pos] = LC3_SAT16(s);
+        pos = pos < nl-1 ? pos + 1 : 0;
+    }
+
+    decoder->xl_pos = pos;
+}
+
+/**
+ * Frame synthesis
+ * decoders, n     Decoder states, of the same configuration, and count
+ * sides           Frames data, a NULL side data performs PLC
+ * nbytes          Size in bytes of the frames, not read on PLC
+ *
+ * The frames are processed together, stage by stage.
+ */
+static void synthesize(struct lc3_decoder * const *decoders, int n,
+    const struct side_data * const *sides, const int *nbytes)
+{
+    enum lc3_dt dt = decoders[0]->dt;
+    enum lc3_srate sr = decoders[0]->sr;
+    enum lc3_srate sr_pcm = decoders[0]->sr_pcm;
     int ns = LC3_NS(dt, sr_pcm);
-    int ne = LC3_NE(dt, sr);
 
-    float *xg = decoder->x + decoder->xg_off;
-    float *xs = xf;
+    /* --- Output at a lower samplerate ---
+     * The spectrum is truncated to the bandwidth of the output,
+     * only the coefficients below are kept, and concealed by PLC. */
+
+    bool truncate = sr > sr_pcm;
+    enum lc3_srate sr_plc = truncate ? sr_pcm : sr;
+    int ne = LC3_NE(dt, sr_plc);
+
+    for (int i = 0; i < n; i++) {
+        struct lc3_decoder *decoder = decoders[i];
+        const struct side_data *side = sides[i];
+        float *xf = decoder->x + decoder->xf_off;
+        float *xg = decoder->x + decoder->xg_off;
+        LC3_PROFILE_BEGIN(t);
+
+        if (side) {
+            lc3_plc_suspend(&decoder->plc);
+
+            decoder->cpu->tns_synthesize(dt, side->bw, &side->tns, xf);
 
-    float *xd = decoder->x + decoder->xd_off;
-    float *xh = decoder->x + decoder->xh_off;
+        } else {
+            lc3_plc_synthesize(dt, sr_plc, &decoder->plc, xg, xf);
 
-    if (side) {
-        enum lc3_bandwidth bw = side->bw;
+            memset(xf + ne, 0, (ns - ne) * sizeof(float));
+        }
 
-        lc3_plc_suspend(&decoder->plc);
+        LC3_PROFILE_END(t, decoder->stats.cycles[
+            side ? LC3_DECODER_STAGE_TNS : LC3_DECODER_STAGE_PLC]);
 
-        lc3_tns_synthesize(dt, bw, &side->tns, xf);
+        LC3_PROFILE_COUNT(decoder->stats.frames, 1);
+        LC3_PROFILE_COUNT(decoder->stats.plc_frames, !side);
+        LC3_PROFILE_COUNT(decoder->stats.ltpf_active,
+            side && side->pitch_present && side->ltpf.active);
+        LC3_PROFILE_COUNT(decoder->stats.tns_filters[0],
+            side && side->tns.nfilters > 0 && side->tns.rc_order[0] > 0);
+        LC3_PROFILE_COUNT(decoder->stats.tns_filters[1],
+            side && side->tns.nfilters > 1 && side->tns.rc_order[1] > 0);
+    }
+
+    for (int i = 0; i < n; i++) {
+        struct lc3_decoder *decoder = decoders[i];
+        float *xf = decoder->x + decoder->xf_off;
+        float *xg = decoder->x + decoder->xg_off;
+        LC3_PROFILE_BEGIN(t);
+
+        if (sides[i] && truncate) {
+            lc3_sns_synthesize(dt, sr, &sides[i]->sns, xf, xf);
+            memcpy(xg, xf, ns * sizeof(float));
 
-        lc3_sns_synthesize(dt, sr, &side->sns, xf, xg);
+        } else if (sides[i]) {
+            lc3_sns_synthesize(dt, sr, &sides[i]->sns, xf, xg);
+        }
 
-        lc3_mdct_inverse(dt, sr_pcm, sr, xg, xd, xs);
+        LC3_PROFILE_END(t, decoder->stats.cycles[LC3_DECODER_STAGE_SNS]);
+    }
 
-    } else {
-        lc3_plc_synthesize(dt, sr, &decoder->plc, xg, xf);
+    for (int i = 0; i < n; i++) {
+        struct lc3_decoder *decoder = decoders[i];
+        float *xs = decoder->x + decoder->xs_off;
+        float *xf = decoder->x + decoder->xf_off;
+        float *xg = decoder->x + decoder->xg_off;
+        float *xd = decoder->x + decoder->xd_off;
+        LC3_PROFILE_BEGIN(t);
 
-        memset(xf + ne, 0, (ns - ne) * sizeof(float));
+        decoder->cpu->mdct_inverse(
+            dt, sr_pcm, sr, sides[i] ? xg : xf, xd, xs);
 
-        lc3_mdct_inverse(dt, sr_pcm, sr, xf, xd, xs);
+        LC3_PROFILE_END(t, decoder->stats.cycles[LC3_DECODER_STAGE_MDCT]);
     }
 
-    lc3_ltpf_synthesize(dt, sr_pcm, nbytes, &decoder->ltpf,
-        side && side->pitch_present ? &side->ltpf : NULL, xh, xs);
+    /* --- Long Term Postfilter ---
+     * The history of compact decoders is widened, when the filter
+     * reads it, in front of a copy of the frame, as in the ring buffer
+     * of the other decoders. */
+
+    int nh = LC3_NH(dt, sr_pcm);
+    int nl = LC3_NL(sr_pcm);
+    float xw[LC3_MAX_NH];
+
+    for (int i = 0; i < n; i++) {
+        struct lc3_decoder *decoder = decoders[i];
+        const struct side_data *side = sides[i];
+        const lc3_ltpf_data_t *ltpf =
+            side && side->pitch_present ? &side->ltpf : NULL;
+        float *xs = decoder->x + decoder->xs_off;
+        float *xh = decoder->x + decoder->xh_off;
+        LC3_PROFILE_BEGIN(t);
+
+        bool widen = decoder->compact &&
+            (decoder->ltpf.active || (ltpf && ltpf->active));
+
+        if (widen) {
+            load_history(decoder, xw + (nh - ns) - nl);
+            memcpy(xw + (nh - ns), xs, ns * sizeof(float));
+        }
+
+        decoder->cpu->ltpf_synthesize(dt, sr_pcm, side ? nbytes[i] : 0,
+            &decoder->ltpf, ltpf,
+            widen ? xw : xh, widen ? xw + (nh - ns) : xs);
+
+        if (widen)
+            memcpy(xs, xw + (nh - ns), ns * sizeof(float));
+
+        LC3_PROFILE_END(t, decoder->stats.cycles[LC3_DECODER_STAGE_LTPF]);
+    }
 }
 
 /**
@@ -610,8 +1034,38 @@ static void complete(struct lc3_decoder *decoder)
     int nh = LC3_NH(dt, sr_pcm);
     int ns = LC3_NS(dt, sr_pcm);
 
+    if (decoder->compact) {
+        store_history(decoder, decoder->x + decoder->xs_off, ns);
+        return;
+    }
+
     decoder->xs_off = decoder->xs_off - decoder->xh_off < nh - ns ?
         decoder->xs_off + ns : decoder->xh_off;
+
+    if (decoder->sr <= decoder->sr_pcm)
+        decoder->xf_off = decoder->xs_off;
+}
+
+/**
+ * Return the statistics of a decoder
+ */
+int lc3_decoder_stats(
+    struct lc3_decoder *decoder, struct lc3_decoder_stats *stats)
+{
+    if (!stats)
+        return -1;
+
+#ifdef LC3_PROFILE
+    if (decoder) {
+        *stats = decoder->stats;
+        return 0;
+    }
+#else
+    (void)decoder;
+#endif
+
+    *stats = (struct lc3_decoder_stats){ 0 };
+    return -1;
 }
 
 /**
@@ -628,10 +1082,28 @@ unsigned lc3_decoder_size(int dt_us, int sr_hz)
 }
 
 /**
- * Setup decoder
+ * Return size needed for a compact decoder
  */
-struct lc3_decoder *lc3_setup_decoder(
-    int dt_us, int sr_hz, int sr_pcm_hz, void *mem)
+unsigned lc3_decoder_size_compact(int dt_us, int sr_hz)
+{
+    if (resolve_dt(dt_us) >= LC3_NUM_DT ||
+        resolve_sr(sr_hz) >= LC3_NUM_SRATE)
+        return 0;
+
+    return sizeof(struct lc3_decoder) +
+        (LC3_DECODER_COMPACT_BUFFER_COUNT(dt_us, sr_hz)-1) * sizeof(float);
+}
+
+/**
+ * Setup decoder, with the normal or compact layout
+ * dt_us, sr_hz    Frame duration and samplerate of the stream
+ * sr_pcm_hz       Samplerate of the output, or 0
+ * compact         True when the history is kept in 16 bits samples
+ * mem             Decoder memory space
+ * return          Decoder, NULL on bad parameters
+ */
+static struct lc3_decoder *setup_decoder(
+    int dt_us, int sr_hz, int sr_pcm_hz, bool compact, void *mem)
 {
     if (sr_pcm_hz <= 0)
         sr_pcm_hz = sr_hz;
@@ -640,7 +1112,8 @@ struct lc3_decoder *lc3_setup_decoder(
     enum lc3_srate sr = resolve_sr(sr_hz);
     enum lc3_srate sr_pcm = resolve_sr(sr_pcm_hz);
 
-    if (dt >= LC3_NUM_DT || sr_pcm >= LC3_NUM_SRATE || sr > sr_pcm || !mem)
+    if (dt >= LC3_NUM_DT || sr >= LC3_NUM_SRATE ||
+            sr_pcm >= LC3_NUM_SRATE || !check_sr_pair(sr_hz, sr_pcm_hz) || !mem)
         return NULL;
 
     struct lc3_decoder *decoder = mem;
@@ -648,24 +1121,69 @@ struct lc3_decoder *lc3_setup_decoder(
     int ns = LC3_NS(dt, sr_pcm);
     int nd = LC3_ND(dt, sr_pcm);
 
+    /* --- Layout of the buffers ---
+     * The spectrum is decoded in place of the output samples, or
+     * following the buffers when the output samplerate is lower.
+     * The buffers then fit in the size given by the stream samplerate.
+     *
+     * The compact layout keeps a single frame of output samples,
+     * where the spectrum is always decoded, the history follows
+     * the buffers, as 16 bits samples. */
+
+    bool truncate = sr > sr_pcm;
+    int nf = truncate ? LC3_NS(dt, sr) : 0;
+    int nl = LC3_NL(sr_pcm);
+
+    if (compact) {
+        nh = LC3_MAX(ns, nf);
+        nf = 0;
+    }
+
+    int nx = nh + nd + ns + nf;
+
     *decoder = (struct lc3_decoder){
         .dt = dt, .sr = sr,
         .sr_pcm = sr_pcm,
+        .cpu = lc3_cpu_ops(),
 
+        .compact = compact,
         .xh_off = 0,
-        .xs_off = nh - ns,
+        .xs_off = compact ? 0 : nh - ns,
         .xd_off = nh,
         .xg_off = nh + nd,
+        .xf_off = nf ? nh + nd + ns : compact ? 0 : nh - ns,
+        .xl_off = compact ? nx : 0,
+        .xl_pos = 0,
     };
 
     lc3_plc_reset(&decoder->plc);
 
-    memset(decoder->x, 0,
-        LC3_DECODER_BUFFER_COUNT(dt_us, sr_pcm_hz) * sizeof(float));
+    memset(decoder->x, 0, nx * sizeof(float));
+
+    if (compact)
+        memset(decoder->x + nx, 0, nl * sizeof(int16_t));
 
     return decoder;
 }
 
+/**
+ * Setup decoder
+ */
+struct lc3_decoder *lc3_setup_decoder(
+    int dt_us, int sr_hz, int sr_pcm_hz, void *mem)
+{
+    return setup_decoder(dt_us, sr_hz, sr_pcm_hz, false, mem);
+}
+
+/**
+ * Setup compact decoder
+ */
+struct lc3_decoder *lc3_setup_decoder_compact(
+    int dt_us, int sr_hz, int sr_pcm_hz, void *mem)
+{
+    return setup_decoder(dt_us, sr_hz, sr_pcm_hz, true, mem);
+}
+
 /**
  * Decode a frame
  */
@@ -691,10 +1209,15 @@ int lc3_decode(struct lc3_decoder *decoder, const void *in, int nbytes,
     /* --- Processing --- */
 
     struct side_data side;
+    LC3_PROFILE_BEGIN(t);
 
     int ret = !in || (decode(decoder, in, nbytes, &side) < 0);
 
-    synthesize(decoder, ret ? NULL : &side, nbytes);
+    LC3_PROFILE_END(t, decoder->stats.cycles[LC3_DECODER_STAGE_DECODE]);
+    LC3_PROFILE_COUNT(decoder->stats.bits_errors, in && ret);
+
+    synthesize(&decoder, 1,
+        (const struct side_data *[]){ ret ? NULL : &side }, &nbytes);
 
     store[fmt](decoder, pcm, stride);
 
@@ -702,3 +1225,265 @@ int lc3_decode(struct lc3_decoder *decoder, const void *in, int nbytes,
 
     return ret;
 }
+
+/**
+ * Decode a frame of a batch of decoders
+ */
+int lc3_decode_batch(struct lc3_decoder * const *decoders, int n,
+    const void * const *in, const int *nbytes,
+    enum lc3_pcm_format fmt, void * const *pcm, int stride, int *status)
+{
+    static void (* const store[])(struct lc3_decoder *, void *, int) = {
+        [LC3_PCM_FORMAT_S16    ] = store_s16,
+        [LC3_PCM_FORMAT_S24    ] = store_s24,
+        [LC3_PCM_FORMAT_S24_3LE] = store_s24_3le,
+        [LC3_PCM_FORMAT_FLOAT  ] = store_float,
+    };
+
+    /* --- Check parameters --- */
+
+    if (!decoders || n < 0)
+        return -1;
+
+    for (int i = 0; i < n; i++) {
+        const struct lc3_decoder *decoder = decoders[i];
+
+        if (!decoder)
+            return -1;
+
+        if (in && in[i] && (!nbytes ||
+                            nbytes[i] < LC3_MIN_FRAME_BYTES ||
+                            nbytes[i] > LC3_MAX_FRAME_BYTES   ))
+            return -1;
+
+        if (decoder->dt != decoders[0]->dt ||
+            decoder->sr != decoders[0]->sr ||
+            decoder->sr_pcm != decoders[0]->sr_pcm)
+            return -1;
+    }
+
+    /* --- Processing, by chunk of batch size --- */
+
+    struct side_data side[LC3_BATCH_SIZE];
+    const struct side_data *sides[LC3_BATCH_SIZE];
+    int nplc = 0;
+
+    for (int i0 = 0; i0 < n; i0 += LC3_BATCH_SIZE) {
+        int nb = LC3_MIN(n - i0, LC3_BATCH_SIZE);
+
+        for (int i = 0; i < nb; i++) {
+            struct lc3_decoder *decoder = decoders[i0+i];
+            const void *data = in ? in[i0+i] : NULL;
+            LC3_PROFILE_BEGIN(t);
+
+            int ret = !data ||
+                (decode(decoder, data, nbytes[i0+i], &side[i]) < 0);
+
+            LC3_PROFILE_END(t,
+                decoder->stats.cycles[LC3_DECODER_STAGE_DECODE]);
+            LC3_PROFILE_COUNT(decoder->stats.bits_errors, data && ret);
+
+            sides[i] = ret ? NULL : &side[i];
+            nplc += ret;
+
+            if (status)
+                status[i0+i] = ret;
+        }
+
+        synthesize(decoders + i0, nb, sides, nbytes ? nbytes + i0 : NULL);
+
+        for (int i = 0; i < nb; i++) {
+            store[fmt](decoders[i0+i], pcm[i0+i], stride);
+
+            complete(decoders[i0+i]);
+        }
+    }
+
+    return nplc;
+}
+
+/**
+ * Parse a frame
+ */
+int lc3_parse_frame(int dt_us, int sr_hz,
+    const void *in, int nbytes, struct lc3_frame_info *info)
+{
+    enum lc3_dt dt = resolve_dt(dt_us);
+    enum lc3_srate sr = resolve_sr(sr_hz);
+
+    /* --- Check parameters --- */
+
+    if (dt >= LC3_NUM_DT || sr >= LC3_NUM_SRATE || !in)
+        return -1;
+
+    if (nbytes < LC3_MIN_FRAME_BYTES ||
+        nbytes > LC3_MAX_FRAME_BYTES   )
+        return -1;
+
+    /* --- Parse the side data and the spectrum --- */
+
+    struct side_data side = { 0 };
+    float x[LC3_MAX_NE];
+    int nf = 0;
+
+    lc3_bits_t bits;
+    lc3_setup_bits(&bits, LC3_BITS_MODE_READ, (void *)in, nbytes);
+
+    int ret = get_side(&bits, dt, sr, nbytes, &side) < 0 ||
+        lc3_spec_parse(&bits, dt, sr, nbytes, &side.spec, x, &nf) < 0 ||
+        lc3_check_bits(&bits) < 0;
+
+    /* --- Return the side data --- */
+
+    if (info) {
+        static const int bw_hz[LC3_NUM_BANDWIDTH] = {
+            [LC3_BANDWIDTH_NB  ] =  4000, [LC3_BANDWIDTH_WB ] =  8000,
+            [LC3_BANDWIDTH_SSWB] = 12000, [LC3_BANDWIDTH_SWB] = 16000,
+            [LC3_BANDWIDTH_FB  ] = 20000,
+        };
+
+        /* The bandwidth is scaled as the duration of frames at 44.1 KHz */
+
+        *info = (struct lc3_frame_info){
+            .bandwidth_hz = sr_hz != 44100 ? bw_hz[side.bw] :
+                            (int)(((int64_t)bw_hz[side.bw] * 44100) / 48000),
+            .g_idx = side.spec.g_idx,
+            .nq = side.spec.nq,
+            .lsb_mode = side.spec.lsb_mode,
+            .pitch_present = side.pitch_present,
+            .ltpf_active = side.ltpf.active,
+            .pitch_index = side.ltpf.pitch_index,
+            .tns_nfilters = side.tns.nfilters,
+            .tns_order = { side.tns.rc_order[0], side.tns.rc_order[1] },
+            .noise_factor = nf,
+        };
+    }
+
+    return ret;
+}
+
+
+/* ----------------------------------------------------------------------------
+ *  Transcoder
+ * -------------------------------------------------------------------------- */
+
+/**
+ * Return size needed for a transcoder
+ */
+unsigned lc3_transcoder_size(int dt_us, int sr_hz)
+{
+    if (resolve_dt(dt_us) >= LC3_NUM_DT ||
+        resolve_sr(sr_hz) >= LC3_NUM_SRATE)
+        return 0;
+
+    return sizeof(struct lc3_transcoder);
+}
+
+/**
+ * Setup transcoder
+ */
+struct lc3_transcoder *lc3_setup_transcoder(int dt_us, int sr_hz, void *mem)
+{
+    enum lc3_dt dt = resolve_dt(dt_us);
+    enum lc3_srate sr = resolve_sr(sr_hz);
+
+    if (dt >= LC3_NUM_DT || sr >= LC3_NUM_SRATE || !mem)
+        return NULL;
+
+    struct lc3_transcoder *transcoder = mem;
+
+    *transcoder = (struct lc3_transcoder){
+        .dt = dt, .sr = sr,
+        .cpu = lc3_cpu_ops(),
+    };
+
+    return transcoder;
+}
+
+/**
+ * Transcode a frame
+ */
+int lc3_transcode(struct lc3_transcoder *transcoder,
+    const void *in, int nbytes_in, int nbytes, void *out)
+{
+    return lc3_transcode_batch(&transcoder, 1, in, nbytes_in, &nbytes, &out);
+}
+
+/**
+ * Transcode a frame to a batch of sizes
+ */
+int lc3_transcode_batch(struct lc3_transcoder * const *transcoders, int n,
+    const void *in, int nbytes_in, const int *nbytes, void * const *out)
+{
+    /* --- Check parameters --- */
+
+    if (!transcoders || n < 1 || !in ||
+            nbytes_in < LC3_MIN_FRAME_BYTES ||
+            nbytes_in > LC3_MAX_FRAME_BYTES   )
+        return -1;
+
+    for (int i = 0; i < n; i++) {
+        const struct lc3_transcoder *transcoder = transcoders[i];
+
+        if (!transcoder || !out[i] || nbytes[i] < LC3_MIN_FRAME_BYTES
+                                   || nbytes[i] > LC3_MAX_FRAME_BYTES)
+            return -1;
+
+        if (transcoder->dt != transcoders[0]->dt ||
+            transcoder->sr != transcoders[0]->sr)
+            return -1;
+    }
+
+    enum lc3_dt dt = transcoders[0]->dt;
+    enum lc3_srate sr = transcoders[0]->sr;
+    int ne = LC3_NE(dt, sr);
+
+    /* --- Decode the side data and the spectrum --- */
+
+    struct side_data side_in;
+    float xf[LC3_MAX_NE];
+
+    lc3_bits_t bits;
+    lc3_setup_bits(&bits, LC3_BITS_MODE_READ, (void *)in, nbytes_in);
+
+    if (get_side(&bits, dt, sr, nbytes_in, &side_in) < 0 ||
+        lc3_spec_decode(&bits, dt, sr,
+            side_in.bw, nbytes_in, &side_in.spec, xf) < 0 ||
+        lc3_check_bits(&bits) < 0)
+        return 1;
+
+    /* --- Requantize the spectrum at each size ---
+     * The bandwidth, SNS, TNS and LTPF data are kept as is, only the
+     * coding of the TNS filters depends on the size of the frame. */
+
+    for (int i = 0; i < n; i++) {
+        struct lc3_transcoder *transcoder = transcoders[i];
+        struct side_data side = side_in;
+        uint16_t xq[LC3_MAX_NE];
+        float x[LC3_MAX_NE];
+
+        if (nbytes[i] == nbytes_in) {
+            memcpy(out[i], in, nbytes_in);
+            continue;
+        }
+
+        lc3_tns_set_nbytes(dt, nbytes[i], &side.tns);
+
+        memcpy(x, xf, ne * sizeof(float));
+
+        transcoder->cpu->spec_analyze(dt, sr,
+            nbytes[i], side.pitch_present, &side.tns, true,
+            &transcoder->spec, x, xq, &side.spec);
+
+        lc3_setup_bits(&bits, LC3_BITS_MODE_WRITE, out[i], nbytes[i]);
+
+        put_side(&bits, dt, sr, &side);
+
+        lc3_spec_encode(&bits,
+            dt, sr, side.bw, nbytes[i], xq, &side.spec, x);
+
+        lc3_flush_bits(&bits);
+    }
+
+    return 0;
+}
@@ -0,0 +1,300 @@
+/******************************************************************************
+ *
+ *  Copyright 2022 Google LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <lc3_mt.h>
+
+#include <pthread.h>
+#include <stdlib.h>
+
+
+/**
+ * Worker thread
+ */
+
+struct worker {
+    struct lc3_mt_encoder *encoder;
+    int index;
+    pthread_t thread;
+};
+
+/**
+ * Multichannel encoder
+ */
+
+struct lc3_mt_encoder {
+    int nch, nthreads, nworkers;
+
+    lc3_encoder_t *enc;
+    struct worker *workers;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t cond_start, cond_done;
+
+    unsigned frame;
+    int pending, ret;
+    bool stop;
+
+    struct {
+        enum lc3_pcm_format fmt;
+        const void *pcm;
+        int nbytes;
+        void *out;
+    } job;
+};
+
+
+/* ----------------------------------------------------------------------------
+ *  Workers
+ * -------------------------------------------------------------------------- */
+
+/**
+ * Encode the channels of the current frame, handled by a thread
+ * encoder         Multichannel encoder
+ * index           Index of the thread, 0 is the caller of `lc3_mt_encode()`
+ * return          0: On success  -1: Wrong parameters
+ */
+static int encode_channels(struct lc3_mt_encoder *encoder, int index)
+{
+    static const int pcm_sbytes[] = {
+        [LC3_PCM_FORMAT_S16    ] = 2,
+        [LC3_PCM_FORMAT_S24    ] = 4,
+        [LC3_PCM_FORMAT_S24_3LE] = 3,
+        [LC3_PCM_FORMAT_FLOAT  ] = 4,
+    };
+
+    int nch = encoder->nch;
+    int sbytes = pcm_sbytes[encoder->job.fmt];
+    int nbytes = encoder->job.nbytes;
+    const uint8_t *pcm = encoder->job.pcm;
+    uint8_t *out = encoder->job.out;
+    int ret = 0;
+
+    for (int ich = index; ich < nch; ich += encoder->nthreads)
+        ret |= lc3_encode(encoder->enc[ich], encoder->job.fmt,
+            pcm + ich * sbytes, nch, nbytes, out + ich * nbytes);
+
+    return ret;
+}
+
+/**
+ * Worker thread loop, waiting for frames until the encoder is stopped
+ */
+static void *worker_run(void *arg)
+{
+    struct worker *worker = arg;
+    struct lc3_mt_encoder *encoder = worker->encoder;
+    unsigned frame = 0;
+
+    pthread_mutex_lock(&encoder->mutex);
+
+    for (;;) {
+        while (!encoder->stop && encoder->frame == frame)
+            pthread_cond_wait(&encoder->cond_start, &encoder->mutex);
+
+        if (encoder->stop)
+            break;
+
+        frame = encoder->frame;
+        pthread_mutex_unlock(&encoder->mutex);
+
+        int ret = encode_channels(encoder, worker->index);
+
+        pthread_mutex_lock(&encoder->mutex);
+
+        encoder->ret |= ret;
+        if (--encoder->pending == 0)
+            pthread_cond_signal(&encoder->cond_done);
+    }
+
+    pthread_mutex_unlock(&encoder->mutex);
+
+    return NULL;
+}
+
+
+/* ----------------------------------------------------------------------------
+ *  Interface
+ * -------------------------------------------------------------------------- */
+
+/**
+ * Setup multichannel encoder
+ */
+struct lc3_mt_encoder *lc3_mt_setup_encoder(
+    int dt_us, int sr_hz, int sr_pcm_hz, int nch, int nthreads)
+{
+    unsigned encoder_size = lc3_encoder_size(
+        dt_us, sr_pcm_hz > 0 ? sr_pcm_hz : sr_hz);
+
+    if (!encoder_size || nch < 1)
+        return NULL;
+
+    if (nthreads <= 0 || nthreads > nch)
+        nthreads = nch;
+
+    struct lc3_mt_encoder *encoder = calloc(1, sizeof(*encoder));
+    if (!encoder)
+        return NULL;
+
+    encoder->nch = nch;
+    encoder->nthreads = nthreads;
+
+    /* --- Setup the synchronization ---
+     * On failure, the objects initialized are destroyed here,
+     * the others are only destroyed by `lc3_mt_free_encoder()` */
+
+    if (pthread_mutex_init(&encoder->mutex, NULL) != 0)
+        goto fail_mutex;
+
+    if (pthread_cond_init(&encoder->cond_start, NULL) != 0)
+        goto fail_cond_start;
+
+    if (pthread_cond_init(&encoder->cond_done, NULL) != 0)
+        goto fail_cond_done;
+
+    /* --- Setup the encoders of the channels --- */
+
+    if (!(encoder->enc = calloc(nch, sizeof(*encoder->enc))))
+        goto fail;
+
+    for (int ich = 0; ich < nch; ich++) {
+        void *mem = malloc(encoder_size);
+
+        if (!(encoder->enc[ich] =
+                lc3_setup_encoder(dt_us, sr_hz, sr_pcm_hz, mem))) {
+            free(mem);
+            goto fail;
+        }
+    }
+
+    /* --- Start the workers --- */
+
+    if (nthreads > 1 &&
+            !(encoder->workers = calloc(nthreads - 1, sizeof(*encoder->workers))))
+        goto fail;
+
+    for (int i = 0; i < nthreads - 1; i++) {
+        struct worker *worker = &encoder->workers[i];
+
+        worker->encoder = encoder;
+        worker->index = 1 + i;
+
+        if (pthread_create(&worker->thread, NULL, worker_run, worker) != 0)
+            goto fail;
+
+        encoder->nworkers++;
+    }
+
+    return encoder;
+
+fail:
+    lc3_mt_free_encoder(encoder);
+    return NULL;
+
+fail_cond_done:
+    pthread_cond_destroy(&encoder->cond_start);
+fail_cond_start:
+    pthread_mutex_destroy(&encoder->mutex);
+fail_mutex:
+    free(encoder);
+    return NULL;
+}
+
+/**
+ * Free multichannel encoder
+ */
+void lc3_mt_free_encoder(struct lc3_mt_encoder *encoder)
+{
+    if (!encoder)
+        return;
+
+    pthread_mutex_lock(&encoder->mutex);
+    encoder->stop = true;
+    pthread_cond_broadcast(&encoder->cond_start);
+    pthread_mutex_unlock(&encoder->mutex);
+
+    for (int i = 0; i < encoder->nworkers; i++)
+        pthread_join(encoder->workers[i].thread, NULL);
+
+    free(encoder->workers);
+
+    for (int ich = 0; encoder->enc && ich < encoder->nch; ich++)
+        free(encoder->enc[ich]);
+
+    free(encoder->enc);
+
+    pthread_cond_destroy(&encoder->cond_done);
+    pthread_cond_destroy(&encoder->cond_start);
+    pthread_mutex_destroy(&encoder->mutex);
+
+    free(encoder);
+}
+
+/**
+ * Return the number of channels of a multichannel encoder
+ */
+int lc3_mt_encoder_channels(struct lc3_mt_encoder *encoder)
+{
+    return encoder ? encoder->nch : -1;
+}
+
+/**
+ * Encode a multichannel frame
+ */
+int lc3_mt_encode(struct lc3_mt_encoder *encoder,
+    enum lc3_pcm_format fmt, const void *pcm, int nbytes, void *out)
+{
+    if (!encoder || !pcm || !out ||
+            fmt < LC3_PCM_FORMAT_S16 || fmt > LC3_PCM_FORMAT_FLOAT)
+        return -1;
+
+    encoder->job.fmt = fmt;
+    encoder->job.pcm = pcm;
+    encoder->job.nbytes = nbytes;
+    encoder->job.out = out;
+
+    if (encoder->nworkers <= 0)
+        return encode_channels(encoder, 0) ? -1 : 0;
+
+    /* --- Start the frame on the workers, and take part --- */
+
+    pthread_mutex_lock(&encoder->mutex);
+
+    encoder->ret = 0;
+    encoder->pending = encoder->nworkers;
+    encoder->frame++;
+    pthread_cond_broadcast(&encoder->cond_start);
+
+    pthread_mutex_unlock(&encoder->mutex);
+
+    int ret = encode_channels(encoder, 0);
+
+    /* --- Wait for completion of the frame --- */
+
+    pthread_mutex_lock(&encoder->mutex);
+
+    while (encoder->pending > 0)
+        pthread_cond_wait(&encoder->cond_done, &encoder->mutex);
+
+    ret |= encoder->ret;
+
+    pthread_mutex_unlock(&encoder->mutex);
+
+    return ret ? -1 : 0;
+}
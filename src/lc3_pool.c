@@ -0,0 +1,243 @@
+/******************************************************************************
+ *
+ *  Copyright 2022 Google LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define _DEFAULT_SOURCE
+
+#include <lc3_pool.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+
+/**
+ * Default size of the slabs, and size of the huge pages
+ */
+
+#define SLAB_SIZE       (2 << 20)
+#define HUGEPAGE_SIZE   (2 << 20)
+
+/**
+ * Policy of `mbind()`, and the number of NUMA nodes handled
+ * The preferred policy falls back to the other nodes, when exhausted
+ */
+
+#define MPOL_PREFERRED  1
+#define MAX_NUMA_NODES  1024
+
+
+/**
+ * Slab, the header takes the first slot of alignment,
+ * the slots follow up to the end of the slab
+ */
+
+struct slab {
+    struct slab *next;
+    size_t size;
+};
+
+/**
+ * Pool
+ * The slots given back are linked by their first word, in `free_slots`.
+ * The last slab mapped is carved from `top` to `end`, on demand.
+ */
+
+struct lc3_pool {
+    size_t slot_size, stride;
+    size_t slab_size;
+    int flags, numa_node;
+
+    struct slab *slabs;
+    uint8_t *top, *end;
+    void *free_slots;
+};
+
+
+/**
+ * Map a slab, unbacked until its pages are touched
+ * pool            The pool
+ * return          The slab, NULL on error
+ */
+static struct slab *map_slab(const struct lc3_pool *pool)
+{
+    size_t size = pool->slab_size;
+    void *mem = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    if (pool->flags & LC3_POOL_HUGEPAGES)
+        mem = mmap(NULL, size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+
+    if (mem == MAP_FAILED) {
+        mem = mmap(NULL, size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED)
+            return NULL;
+
+#ifdef MADV_HUGEPAGE
+        if (pool->flags & LC3_POOL_HUGEPAGES)
+            madvise(mem, size, MADV_HUGEPAGE);
+#endif
+    }
+
+    /* --- Prefer the NUMA node, before the pages are touched ---
+     * The policy is a hint, the slab is used as is on failure */
+
+#if defined(__linux__) && defined(SYS_mbind)
+    if (pool->numa_node >= 0) {
+        unsigned long mask[MAX_NUMA_NODES / (8 * sizeof(long))] = { 0 };
+        const int nbits = 8 * sizeof(*mask);
+
+        mask[pool->numa_node / nbits] |= 1ul << (pool->numa_node % nbits);
+        syscall(SYS_mbind, mem, size,
+            MPOL_PREFERRED, mask, MAX_NUMA_NODES + 1, 0);
+    }
+#endif
+
+    struct slab *slab = mem;
+    *slab = (struct slab){ .size = size };
+
+    return slab;
+}
+
+/**
+ * Setup a pool
+ */
+struct lc3_pool *lc3_pool_setup(
+    unsigned slot_size, unsigned slab_size, int flags, int numa_node)
+{
+    if (!slot_size || numa_node >= MAX_NUMA_NODES)
+        return NULL;
+
+    size_t stride = ((size_t)slot_size + LC3_POOL_ALIGN - 1) &
+                    ~(size_t)(LC3_POOL_ALIGN - 1);
+
+    /* --- Round up the slabs to the pages ---
+     * A slab holds the header, and at least one slot */
+
+    size_t page_size = (flags & LC3_POOL_HUGEPAGES) ?
+        HUGEPAGE_SIZE : (size_t)sysconf(_SC_PAGESIZE);
+
+    size_t size = slab_size ? slab_size : SLAB_SIZE;
+    if (size < LC3_POOL_ALIGN + stride)
+        size = LC3_POOL_ALIGN + stride;
+
+    size = (size + page_size - 1) & ~(page_size - 1);
+
+    /* --- Allocate the pool --- */
+
+    struct lc3_pool *pool = malloc(sizeof(*pool));
+    if (!pool)
+        return NULL;
+
+    *pool = (struct lc3_pool){
+        .slot_size = slot_size, .stride = stride,
+        .slab_size = size,
+        .flags = flags, .numa_node = numa_node < 0 ? -1 : numa_node,
+    };
+
+    return pool;
+}
+
+/**
+ * Free a pool
+ */
+void lc3_pool_free(struct lc3_pool *pool)
+{
+    if (!pool)
+        return;
+
+    for (struct slab *slab = pool->slabs, *next; slab; slab = next) {
+        next = slab->next;
+        munmap(slab, slab->size);
+    }
+
+    free(pool);
+}
+
+/**
+ * Return the size of the slots of a pool
+ */
+unsigned lc3_pool_slot_size(struct lc3_pool *pool)
+{
+    return pool ? pool->slot_size : 0;
+}
+
+/**
+ * Take a slot of a pool
+ */
+void *lc3_pool_get(struct lc3_pool *pool, unsigned size)
+{
+    if (!pool)
+        return size ? malloc(size) : NULL;
+
+    if (!size || size > pool->slot_size)
+        return NULL;
+
+    /* --- Reuse a slot given back --- */
+
+    if (pool->free_slots) {
+        void *mem = pool->free_slots;
+        pool->free_slots = *(void **)mem;
+        return mem;
+    }
+
+    /* --- Carve a new slot, mapping a new slab when exhausted --- */
+
+    if (pool->end - pool->top < (ptrdiff_t)pool->stride) {
+        struct slab *slab = map_slab(pool);
+        if (!slab)
+            return NULL;
+
+        slab->next = pool->slabs;
+        pool->slabs = slab;
+
+        pool->top = (uint8_t *)slab + LC3_POOL_ALIGN;
+        pool->end = (uint8_t *)slab + slab->size;
+    }
+
+    void *mem = pool->top;
+    pool->top += pool->stride;
+
+    return mem;
+}
+
+/**
+ * Give back a slot to its pool
+ */
+void lc3_pool_put(struct lc3_pool *pool, void *mem)
+{
+    if (!pool) {
+        free(mem);
+        return;
+    }
+
+    if (!mem)
+        return;
+
+    *(void **)mem = pool->free_slots;
+    pool->free_slots = mem;
+}
@@ -0,0 +1,606 @@
+/******************************************************************************
+ *
+ *  Copyright 2022 Google LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <lc3_stream.h>
+#include <lc3_header.h>
+
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+
+
+/**
+ * Size in bytes of the PCM samples, by format
+ */
+
+static const int pcm_sbytes[] = {
+    [LC3_PCM_FORMAT_S16    ] = 2,
+    [LC3_PCM_FORMAT_S24    ] = 4,
+    [LC3_PCM_FORMAT_S24_3LE] = 3,
+    [LC3_PCM_FORMAT_FLOAT  ] = 4,
+};
+
+/**
+ * Alignment in bytes of the PCM samples, by format
+ */
+
+static const int pcm_align[] = {
+    [LC3_PCM_FORMAT_S16    ] = alignof(int16_t),
+    [LC3_PCM_FORMAT_S24    ] = alignof(int32_t),
+    [LC3_PCM_FORMAT_S24_3LE] = 1,
+    [LC3_PCM_FORMAT_FLOAT  ] = alignof(float),
+};
+
+
+/* ----------------------------------------------------------------------------
+ *  Encoder
+ * -------------------------------------------------------------------------- */
+
+/**
+ * Stream encoder
+ * The encoder states of the channels, and the `pending` buffer, holding
+ * a frame of interleaved samples, follow the structure
+ */
+
+struct lc3_stream_encoder {
+    int dt_us, sr_hz, sr_pcm_hz;
+    int nch, bitrate;
+    enum lc3_pcm_format fmt;
+
+    int frame_bytes, frame_samples;
+    int block_bytes;
+
+    int npending;
+    int nflush;
+    bool started, flushing;
+
+    uint8_t *pending;
+    lc3_encoder_t enc[];
+};
+
+/**
+ * Encode a frame of the channels, in a record
+ * encoder         Stream encoder
+ * pcm             Frame of interleaved samples
+ * slot            Output record
+ */
+static void encode_record(struct lc3_stream_encoder *encoder,
+    const uint8_t *pcm, uint8_t *slot)
+{
+    int nch = encoder->nch;
+    int sbytes = pcm_sbytes[encoder->fmt];
+    int nbytes = encoder->frame_bytes;
+    uint16_t size = nch * nbytes;
+
+    memcpy(slot, &size, sizeof(size));
+    slot += sizeof(size);
+
+    for (int ich = 0; ich < nch; ich++)
+        lc3_encode(encoder->enc[ich], encoder->fmt,
+            pcm + ich * sbytes, nch, nbytes, slot + ich * nbytes);
+}
+
+/**
+ * Setup stream encoder
+ */
+struct lc3_stream_encoder *lc3_stream_setup_encoder(int dt_us, int sr_hz,
+    int sr_pcm_hz, int nch, int bitrate, enum lc3_pcm_format fmt)
+{
+    if (sr_pcm_hz <= 0)
+        sr_pcm_hz = sr_hz;
+
+    unsigned encoder_size = lc3_encoder_size(dt_us, sr_pcm_hz);
+    if (!encoder_size || !LC3_CHECK_SR_HZ(sr_hz) || sr_hz > sr_pcm_hz ||
+            (sr_hz == 44100) != (sr_pcm_hz == 44100) ||
+            nch < 1 || bitrate <= 0 || (unsigned)fmt > LC3_PCM_FORMAT_FLOAT)
+        return NULL;
+
+    encoder_size = (encoder_size + alignof(max_align_t) - 1) &
+                   ~(alignof(max_align_t) - 1);
+
+    int frame_samples = lc3_frame_samples(dt_us, sr_pcm_hz);
+    int block_bytes = frame_samples * nch * pcm_sbytes[fmt];
+
+    size_t size = sizeof(struct lc3_stream_encoder) +
+        nch * sizeof(lc3_encoder_t) + alignof(max_align_t) +
+        nch * encoder_size + block_bytes;
+
+    struct lc3_stream_encoder *encoder = malloc(size);
+    if (!encoder)
+        return NULL;
+
+    *encoder = (struct lc3_stream_encoder){
+        .dt_us = dt_us, .sr_hz = sr_hz, .sr_pcm_hz = sr_pcm_hz,
+        .nch = nch, .bitrate = bitrate, .fmt = fmt,
+
+        .frame_bytes = lc3_frame_bytes_ex(dt_us, sr_hz, bitrate / nch),
+        .frame_samples = frame_samples,
+        .block_bytes = block_bytes,
+    };
+
+    uintptr_t mem = (uintptr_t)(encoder->enc + nch);
+    mem = (mem + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1);
+
+    for (int ich = 0; ich < nch; ich++)
+        encoder->enc[ich] = (lc3_encoder_t)(mem + ich * encoder_size);
+
+    encoder->pending = (uint8_t *)(mem + nch * encoder_size);
+
+    for (int ich = 0; ich < nch; ich++)
+        lc3_setup_encoder(dt_us, sr_hz, sr_pcm_hz, encoder->enc[ich]);
+
+    return encoder;
+}
+
+/**
+ * Free stream encoder
+ */
+void lc3_stream_free_encoder(struct lc3_stream_encoder *encoder)
+{
+    free(encoder);
+}
+
+/**
+ * Write the header of the LC3 binary format
+ */
+int lc3_stream_encoder_header(
+    struct lc3_stream_encoder *encoder, int nsamples, void *out)
+{
+    struct lc3bin_header hdr;
+
+    if (!encoder || !out || nsamples < 0)
+        return -1;
+
+    nsamples = ((int64_t)nsamples * encoder->sr_hz) / encoder->sr_pcm_hz;
+
+    if (lc3bin_header_init(encoder->dt_us, encoder->sr_hz,
+            encoder->bitrate, encoder->nch, nsamples, &hdr) < 0)
+        return -1;
+
+    hdr.rfu = 0;
+    memcpy(out, &hdr, LC3_HDR_SIZ);
+
+    return LC3_HDR_SIZ;
+}
+
+/**
+ * Return the size of the slots of the records
+ */
+int lc3_stream_encoder_slot_size(struct lc3_stream_encoder *encoder)
+{
+    if (!encoder)
+        return -1;
+
+    return sizeof(uint16_t) + encoder->nch * encoder->frame_bytes;
+}
+
+/**
+ * Encode a chunk of PCM samples
+ */
+int lc3_stream_encode(struct lc3_stream_encoder *encoder,
+    const void *_pcm, int size, int *consumed, void *_slots, int nslots)
+{
+    const uint8_t *pcm = _pcm;
+    uint8_t *slots = _slots;
+
+    if (!encoder || (!pcm && size > 0) || size < 0 ||
+            (!slots && nslots > 0) || nslots < 0 || encoder->flushing)
+        return -1;
+
+    int block_bytes = encoder->block_bytes;
+    int slot_size = lc3_stream_encoder_slot_size(encoder);
+    int nrecords = 0, n = 0;
+
+    while (n < size) {
+        const uint8_t *block = pcm + n;
+
+        /* --- Encode directly from the input --- */
+
+        if (encoder->npending == 0 && size - n >= block_bytes &&
+                (uintptr_t)block % pcm_align[encoder->fmt] == 0) {
+
+            if (nrecords >= nslots)
+                break;
+
+            encode_record(encoder, block, slots + nrecords * slot_size);
+            nrecords++, n += block_bytes;
+            continue;
+        }
+
+        /* --- Complete the pending frame --- */
+
+        int ncopy = block_bytes - encoder->npending;
+        if (ncopy > size - n)
+            ncopy = size - n;
+        else if (nrecords >= nslots)
+            break;
+
+        memcpy(encoder->pending + encoder->npending, block, ncopy);
+        encoder->npending += ncopy, n += ncopy;
+
+        if (encoder->npending < block_bytes)
+            break;
+
+        encode_record(encoder,
+            encoder->pending, slots + nrecords * slot_size);
+        nrecords++, encoder->npending = 0;
+    }
+
+    encoder->started |= n > 0;
+
+    if (consumed)
+        *consumed = n;
+
+    return nrecords;
+}
+
+/**
+ * Flush the end of the stream
+ */
+int lc3_stream_encoder_flush(
+    struct lc3_stream_encoder *encoder, void *_slots, int nslots)
+{
+    uint8_t *slots = _slots;
+
+    if (!encoder || (!slots && nslots > 0) || nslots < 0)
+        return -1;
+
+    int sbytes = pcm_sbytes[encoder->fmt];
+    int block_bytes = encoder->block_bytes;
+    int slot_size = lc3_stream_encoder_slot_size(encoder);
+    int nrecords = 0;
+
+    if (!encoder->started)
+        return 0;
+
+    if (!encoder->flushing) {
+        encoder->flushing = true;
+        encoder->nflush = encoder->npending / (encoder->nch * sbytes) +
+            lc3_delay_samples(encoder->dt_us, encoder->sr_pcm_hz);
+    }
+
+    for ( ; encoder->nflush > 0 && nrecords < nslots; nrecords++) {
+        memset(encoder->pending + encoder->npending, 0,
+            block_bytes - encoder->npending);
+
+        encode_record(encoder,
+            encoder->pending, slots + nrecords * slot_size);
+
+        encoder->npending = 0;
+        encoder->nflush -= encoder->frame_samples;
+    }
+
+    if (encoder->nflush <= 0) {
+        encoder->started = encoder->flushing = false;
+
+        for (int ich = 0; ich < encoder->nch; ich++)
+            lc3_setup_encoder(encoder->dt_us,
+                encoder->sr_hz, encoder->sr_pcm_hz, encoder->enc[ich]);
+    }
+
+    return nrecords;
+}
+
+
+/* ----------------------------------------------------------------------------
+ *  Decoder
+ * -------------------------------------------------------------------------- */
+
+/**
+ * Stream decoder
+ * The decoder states, the record and the PCM buffers are allocated
+ * on reception of the header, and follow the `dec` array
+ */
+
+struct lc3_stream_decoder {
+    int sr_pcm_hz;
+    enum lc3_pcm_format fmt;
+
+    struct {
+        uint8_t data[LC3_HDR_SIZ];
+        int n;
+        bool done;
+    } header;
+
+    int dt_us, sr_hz, nch;
+    int nsamples, frame_samples;
+
+    int nskip, nout;
+    bool ended;
+
+    uint8_t *record;
+    int nrecord, record_size;
+
+    uint8_t *pcm;
+    int pcm_off, pcm_len;
+
+    lc3_decoder_t *dec;
+};
+
+/**
+ * Parse the header, and allocate the states of the channels
+ * decoder         Stream decoder
+ * return          0: On success  -1: Bad header, or allocation failure
+ */
+static int setup_channels(struct lc3_stream_decoder *decoder)
+{
+    struct lc3bin_header hdr;
+
+    if (lc3bin_header_from_bytes(
+            decoder->header.data, LC3_HDR_SIZ, &hdr) < 0)
+        return -1;
+
+    int dt_us = hdr.frame_10us * 10;
+    int sr_hz = hdr.srate_100hz * 100;
+    int nch = hdr.channels;
+    int nsamples = hdr.nsamples_low | (hdr.nsamples_high << 16);
+
+    int sr_pcm_hz = decoder->sr_pcm_hz ? decoder->sr_pcm_hz : sr_hz;
+
+    unsigned decoder_size = lc3_decoder_size(dt_us, LC3_MAX(sr_hz, sr_pcm_hz));
+    if (!decoder_size || !LC3_CHECK_SR_HZ(sr_hz) ||
+            !LC3_CHECK_SR_HZ(sr_pcm_hz) ||
+            (sr_hz == 44100) != (sr_pcm_hz == 44100) || nch < 1)
+        return -1;
+
+    decoder_size = (decoder_size + alignof(max_align_t) - 1) &
+                   ~(alignof(max_align_t) - 1);
+
+    int frame_samples = lc3_frame_samples(dt_us, sr_pcm_hz);
+
+    uint8_t *mem = malloc(nch * sizeof(lc3_decoder_t) +
+        alignof(max_align_t) + nch * decoder_size +
+        nch * LC3_MAX_FRAME_BYTES + nch * frame_samples * sizeof(int32_t));
+    if (!mem)
+        return -1;
+
+    decoder->dec = (lc3_decoder_t *)mem;
+
+    uintptr_t p = (uintptr_t)(decoder->dec + nch);
+    p = (p + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1);
+
+    for (int ich = 0; ich < nch; ich++)
+        decoder->dec[ich] = lc3_setup_decoder(
+            dt_us, sr_hz, sr_pcm_hz, (void *)(p + ich * decoder_size));
+
+    decoder->pcm = (uint8_t *)(p + nch * decoder_size);
+    decoder->record = decoder->pcm + nch * frame_samples * sizeof(int32_t);
+
+    decoder->dt_us = dt_us;
+    decoder->sr_hz = sr_hz;
+    decoder->sr_pcm_hz = sr_pcm_hz;
+    decoder->nch = nch;
+    decoder->nsamples = ((int64_t)nsamples * sr_pcm_hz) / sr_hz;
+    decoder->frame_samples = frame_samples;
+    decoder->nskip = lc3_delay_samples(dt_us, sr_pcm_hz);
+
+    return 0;
+}
+
+/**
+ * Decode the record received, and make its samples pending
+ * decoder         Stream decoder
+ */
+static void decode_record(struct lc3_stream_decoder *decoder)
+{
+    int nch = decoder->nch;
+    int sbytes = pcm_sbytes[decoder->fmt];
+    int ns = decoder->frame_samples;
+    int nbytes = (decoder->record_size - sizeof(uint16_t)) / nch;
+    const uint8_t *in = decoder->record + sizeof(uint16_t);
+
+    for (int ich = 0; ich < nch; ich++)
+        lc3_decode(decoder->dec[ich], nbytes ? in + ich * nbytes : NULL,
+            nbytes, decoder->fmt, decoder->pcm + ich * sbytes, nch);
+
+    int nskip = LC3_MIN(decoder->nskip, ns);
+    int nout = ns - nskip;
+
+    if (decoder->nsamples > 0)
+        nout = LC3_MIN(nout, decoder->nsamples - decoder->nout);
+
+    decoder->nskip -= nskip;
+    decoder->nout += nout;
+
+    decoder->pcm_off = nskip * nch * sbytes;
+    decoder->pcm_len = nout * nch * sbytes;
+}
+
+/**
+ * Make pending the silence completing a truncated stream
+ * decoder         Stream decoder
+ */
+static void complete_stream(struct lc3_stream_decoder *decoder)
+{
+    int nch = decoder->nch;
+    int sbytes = pcm_sbytes[decoder->fmt];
+    int nout = decoder->nsamples - decoder->nout;
+
+    if (!decoder->ended || decoder->pcm_len > 0 || nout <= 0)
+        return;
+
+    nout = LC3_MIN(nout, decoder->frame_samples);
+    memset(decoder->pcm, 0, nout * nch * sbytes);
+
+    decoder->nout += nout;
+    decoder->pcm_off = 0;
+    decoder->pcm_len = nout * nch * sbytes;
+}
+
+/**
+ * Setup stream decoder
+ */
+struct lc3_stream_decoder *lc3_stream_setup_decoder(
+    int sr_pcm_hz, enum lc3_pcm_format fmt)
+{
+    if ((sr_pcm_hz && !LC3_CHECK_SR_HZ(sr_pcm_hz)) ||
+            (unsigned)fmt > LC3_PCM_FORMAT_FLOAT)
+        return NULL;
+
+    struct lc3_stream_decoder *decoder = malloc(sizeof(*decoder));
+    if (!decoder)
+        return NULL;
+
+    *decoder = (struct lc3_stream_decoder){
+        .sr_pcm_hz = sr_pcm_hz, .fmt = fmt };
+
+    return decoder;
+}
+
+/**
+ * Free stream decoder
+ */
+void lc3_stream_free_decoder(struct lc3_stream_decoder *decoder)
+{
+    if (!decoder)
+        return;
+
+    free(decoder->dec);
+    free(decoder);
+}
+
+/**
+ * Return the parameters of the stream decoded
+ */
+int lc3_stream_decoder_info(struct lc3_stream_decoder *decoder,
+    int *dt_us, int *sr_pcm_hz, int *nch, int *nsamples)
+{
+    if (!decoder || !decoder->header.done)
+        return -1;
+
+    if (dt_us) *dt_us = decoder->dt_us;
+    if (sr_pcm_hz) *sr_pcm_hz = decoder->sr_pcm_hz;
+    if (nch) *nch = decoder->nch;
+    if (nsamples) *nsamples = decoder->nsamples;
+
+    return 0;
+}
+
+/**
+ * Push a chunk of the LC3 binary format
+ */
+int lc3_stream_decoder_push(
+    struct lc3_stream_decoder *decoder, const void *_in, int size)
+{
+    const uint8_t *in = _in;
+    int n = 0;
+
+    if (!decoder || (!in && size > 0) || size < 0)
+        return -1;
+
+    /* --- Header --- */
+
+    if (!decoder->header.done) {
+        int ncopy = LC3_MIN(size, (int)LC3_HDR_SIZ - decoder->header.n);
+
+        memcpy(decoder->header.data + decoder->header.n, in, ncopy);
+        decoder->header.n += ncopy, n += ncopy;
+
+        if (decoder->header.n < (int)LC3_HDR_SIZ)
+            return n;
+
+        if (setup_channels(decoder) < 0)
+            return -1;
+
+        decoder->header.done = true;
+        decoder->record_size = sizeof(uint16_t);
+    }
+
+    /* --- Records --- */
+
+    while (n < size && decoder->pcm_len == 0) {
+        int ncopy = LC3_MIN(size - n,
+            decoder->record_size - decoder->nrecord);
+
+        memcpy(decoder->record + decoder->nrecord, in + n, ncopy);
+        decoder->nrecord += ncopy, n += ncopy;
+
+        if (decoder->nrecord < decoder->record_size)
+            break;
+
+        if (decoder->nrecord == sizeof(uint16_t)) {
+            uint16_t nbytes;
+            memcpy(&nbytes, decoder->record, sizeof(nbytes));
+
+            if (nbytes > decoder->nch * LC3_MAX_FRAME_BYTES ||
+                    nbytes % decoder->nch ||
+                    (nbytes && nbytes < decoder->nch * LC3_MIN_FRAME_BYTES))
+                return -1;
+
+            decoder->record_size += nbytes;
+            if (nbytes)
+                continue;
+        }
+
+        decode_record(decoder);
+
+        decoder->nrecord = 0;
+        decoder->record_size = sizeof(uint16_t);
+    }
+
+    return n;
+}
+
+/**
+ * Return the size of the pending output
+ */
+int lc3_stream_decoder_pending(struct lc3_stream_decoder *decoder)
+{
+    if (!decoder)
+        return -1;
+
+    return decoder->pcm_len;
+}
+
+/**
+ * Pull the pending output
+ */
+int lc3_stream_decoder_pull(
+    struct lc3_stream_decoder *decoder, void *pcm, int size)
+{
+    if (!decoder || (!pcm && size > 0) || size < 0)
+        return -1;
+
+    int n = LC3_MIN(size, decoder->pcm_len);
+
+    memcpy(pcm, decoder->pcm + decoder->pcm_off, n);
+    decoder->pcm_off += n;
+    decoder->pcm_len -= n;
+
+    complete_stream(decoder);
+
+    return n;
+}
+
+/**
+ * Signal the end of the input
+ */
+int lc3_stream_decoder_end(struct lc3_stream_decoder *decoder)
+{
+    if (!decoder)
+        return -1;
+
+    decoder->ended = decoder->header.done;
+
+    complete_stream(decoder);
+
+    return 0;
+}
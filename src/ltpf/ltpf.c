@@ -21,6 +21,7 @@
 
 #include "ltpf_neon.h"
 #include "ltpf_arm.h"
+#include "ltpf_sse.h"
 
 
 /* ----------------------------------------------------------------------------
@@ -525,13 +526,14 @@ LC3_HOT static float interpolate_corr(const float *x, int d)
  * Pitch detection algorithm (3.3.9.5-6)
  * ltpf            Context of analysis
  * x, n            [-114..-17] Previous, [0..n-1] Current 6.4KHz samples
+ * track           Track a stable pitch, instead of a complete search
  * tc              Return the pitch-lag estimation
  * return          True when pitch present
  *
  * The `x` vector is aligned on 32 bits
  */
-static bool detect_pitch(
-    struct lc3_ltpf_analysis *ltpf, const int16_t *x, int n, int *tc)
+static bool detect_pitch(struct lc3_ltpf_analysis *ltpf,
+    const int16_t *x, int n, bool track, int *tc)
 {
     float rm1, rm2;
     float r[98];
@@ -540,6 +542,27 @@ static bool detect_pitch(
     int k0 = LC3_MAX(   0, ltpf->tc-4);
     int nk = LC3_MIN(nr-1, ltpf->tc+4) - k0 + 1;
 
+    /* --- Tracking of a stable pitch ---
+     * When the previous pitch is well correlated, only the lags
+     * around the previous estimation are searched */
+
+    if (track && ltpf->nc[0] > 0.9f) {
+        correlate(x, x - (r0 + k0), n, r + k0, nk);
+
+        int t2 = k0 + argmax(r + k0, nk, &rm2);
+        const int16_t *x2 = x - (r0 + t2);
+
+        float nc2 = rm2 <= 0 ? 0 :
+            rm2 / sqrtf(dot(x, x, n) * dot(x2, x2, n));
+
+        ltpf->tc = t2;
+
+        *tc = r0 + ltpf->tc;
+        return nc2 > 0.6f;
+    }
+
+    /* --- Complete search --- */
+
     correlate(x, x - r0, n, r, nr);
 
     int t1 = argmax_weighted(r, nr, -.5f/(nr-1), &rm1);
@@ -608,9 +631,9 @@ static int refine_pitch(const int16_t *x, int n, int tc, int *pitch)
 /**
  * LTPF Analysis
  */
-bool lc3_ltpf_analyse(
-    enum lc3_dt dt, enum lc3_srate sr, struct lc3_ltpf_analysis *ltpf,
-    const int16_t *x, struct lc3_ltpf_data *data)
+bool lc3_ltpf_analyse(enum lc3_dt dt, enum lc3_srate sr, bool track,
+    struct lc3_ltpf_analysis *ltpf, const int16_t *x,
+    struct lc3_ltpf_data *data)
 {
     /* --- Resampling to 12.8 KHz --- */
 
@@ -643,7 +666,7 @@ bool lc3_ltpf_analyse(
     int tc, pitch = 0;
     float nc = 0;
 
-    bool pitch_present = detect_pitch(ltpf, x_6k4, n_6k4, &tc);
+    bool pitch_present = detect_pitch(ltpf, x_6k4, n_6k4, track, &tc);
 
     if (pitch_present) {
         int16_t u[128], v[128];
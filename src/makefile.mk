@@ -28,16 +28,44 @@ liblc3_src += \
     $(SRC_DIR)/spec/spec.c \
     $(SRC_DIR)/tables/tables.c \
     $(SRC_DIR)/tns/tns.c\
+    $(SRC_DIR)/cpu/cpu.c\
     $(SRC_DIR)/header/header.c\
     $(SRC_DIR)/bytestream/bytestream.c\
     $(SRC_DIR)/wave/wave.c\
+    $(SRC_DIR)/resample/resample.c\
     $(SRC_DIR)/lc3bin.c\
     $(SRC_DIR)/lc3.c\
+    $(SRC_DIR)/lc3_mt.c\
+    $(SRC_DIR)/lc3_stream.c\
+    $(SRC_DIR)/lc3_pool.c\
     $(SRC_DIR)/file_coder.c\
     $(SRC_DIR)/stream_coder.c
 
 liblc3_cflags += -ffast-math
 
+#
+# On x86, the DSP modules are also built for each processor level,
+# the level is selected at runtime (see `src/cpu/cpu.c`)
+#
+
+liblc3_cpu_modules := attdet mdct ltpf sns tns spec
+
+ifneq ($(filter x86_64% i386% i486% i586% i686%,$(shell $(CC) -dumpmachine)),)
+
+liblc3_src += \
+    $(foreach m,$(liblc3_cpu_modules),$(SRC_DIR)/$(m)/$(m)_sse4.c) \
+    $(foreach m,$(liblc3_cpu_modules),$(SRC_DIR)/$(m)/$(m)_avx2.c)
+
+$(BUILD_DIR)/$(SRC_DIR)/%_sse4.o: CFLAGS += -msse4.1
+$(BUILD_DIR)/$(SRC_DIR)/%_avx2.o: CFLAGS += -mavx2
+
+# The analysis (TNS, SNS, LTPF, ...) takes its decisions on floating-point
+# errors, FMA is enabled only for the MDCT, which uses it explicitly,
+# so that the other modules remain the same as the other levels
+$(BUILD_DIR)/$(SRC_DIR)/mdct/mdct_avx2.o: CFLAGS += -mfma
+
+endif
+
 $(eval $(call add-lib,liblc3))
 
 default: liblc3
@@ -20,6 +20,7 @@
 #include "tables.h"
 
 #include "mdct_neon.h"
+#include "mdct_sse.h"
 
 
 /* ----------------------------------------------------------------------------
@@ -204,6 +205,7 @@ static struct lc3_complex *fft(const struct lc3_complex *x, int n,
  * x, y            Input current and delayed samples
  * y, d            Output windowed samples, and delayed ones
  */
+#ifndef mdct_window
 LC3_HOT static void mdct_window(enum lc3_dt dt, enum lc3_srate sr,
     const float *x, float *d, float *y)
 {
@@ -232,6 +234,7 @@ LC3_HOT static void mdct_window(enum lc3_dt dt, enum lc3_srate sr,
         *(y1++) = (*(d0++) = *(x0++)) * *(w2++) + (*d1 = *(--x1)) * *(--w3);
     }
 }
+#endif /* mdct_window */
 
 /**
  * Pre-rotate MDCT coefficients of N/2 points, before FFT N/4 points FFT
@@ -240,6 +243,7 @@ LC3_HOT static void mdct_window(enum lc3_dt dt, enum lc3_srate sr,
  *
  * `x` and y` can be the same buffer
  */
+#ifndef mdct_pre_fft
 LC3_HOT static void mdct_pre_fft(const struct lc3_mdct_rot_def *def,
     const float *x, struct lc3_complex *y)
 {
@@ -262,6 +266,7 @@ LC3_HOT static void mdct_pre_fft(const struct lc3_mdct_rot_def *def,
         *(--y1) = v;
     }
 }
+#endif /* mdct_pre_fft */
 
 /**
  * Post-rotate FFT N/4 points coefficients, resulting MDCT N points
@@ -270,6 +275,7 @@ LC3_HOT static void mdct_pre_fft(const struct lc3_mdct_rot_def *def,
  *
  * `x` and y` can be the same buffer
  */
+#ifndef mdct_post_fft
 LC3_HOT static void mdct_post_fft(const struct lc3_mdct_rot_def *def,
     const struct lc3_complex *x, float *y)
 {
@@ -292,6 +298,7 @@ LC3_HOT static void mdct_post_fft(const struct lc3_mdct_rot_def *def,
         *(--y1) = v0;  *(--y1) = v1;
     }
 }
+#endif /* mdct_post_fft */
 
 /**
  * Pre-rotate IMDCT coefficients of N points, before FFT N/4 points FFT
@@ -0,0 +1,427 @@
+#include "resample.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI  3.14159265358979323846
+#endif
+
+/**
+ * Zero-crossings of the filter on each side, at the lower samplerate,
+ * its cutoff relative to the lower Nyquist frequency,
+ * and the Kaiser window parameter
+ */
+#define RESAMPLE_ZEROS      24
+#define RESAMPLE_CUTOFF     0.9
+#define RESAMPLE_BETA       8.0
+
+/**
+ * The number of taps is rounded to a multiple of 8 floats,
+ * for the vectorization of the dot products
+ */
+#define RESAMPLE_ALIGN      8
+
+/**
+ * Size in bytes of the samples of the PCM formats
+ */
+static const int pcm_sbytes[] = {
+    [LC3_PCM_FORMAT_S16    ] = 2, [LC3_PCM_FORMAT_S24  ] = 4,
+    [LC3_PCM_FORMAT_S24_3LE] = 3, [LC3_PCM_FORMAT_FLOAT] = 4,
+};
+
+
+/**
+ * @brief return the LC3 samplerate coding a PCM samplerate
+*/
+int resample_lc3_hz(const int hz)
+{
+    return LC3_CHECK_SR_HZ(hz) ? hz :
+           hz == 11025 ? 16000 : hz == 22050 ? 24000 :
+           hz == 88200 ? 44100 : hz == 96000 ? 48000 : 0;
+}
+
+/**
+ * @brief return true when the codec converts itself between samplerates
+*/
+bool resample_lc3_native(const int lc3_hz, const int pcm_hz)
+{
+    return LC3_CHECK_SR_HZ(lc3_hz) && LC3_CHECK_SR_HZ(pcm_hz) &&
+           (44100 == lc3_hz) == (44100 == pcm_hz);
+}
+
+/**
+ * @brief return the samplerate to decode a stream, before resampling
+*/
+int resample_dec_hz(const int lc3_hz, const int pcm_hz)
+{
+    if(resample_lc3_native(lc3_hz, pcm_hz)){
+        return pcm_hz;
+    }
+
+    const int hz = resample_lc3_hz(pcm_hz);
+    return resample_lc3_native(lc3_hz, hz) && hz < lc3_hz ? hz : lc3_hz;
+}
+
+/**
+ * modified Bessel function of first kind and order 0
+*/
+static
+double bessel_i0(const double x)
+{
+    double sum = 1, term = 1;
+
+    for (int k = 1; k < 32; k++){
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum += term;
+    }
+
+    return sum;
+}
+
+static
+int gcd(int a, int b)
+{
+    while (b){
+        const int r = a % b;
+        a = b;
+        b = r;
+    }
+
+    return a;
+}
+
+/**
+ * @brief init a resampler
+ *
+ * @return 0 = ok, -1 = bad parameters or allocation failure
+*/
+int resampler_init(resampler_t * const rs,
+                   const int in_hz,
+                   const int out_hz,
+                   const int nch,
+                   const int max_in)
+{
+    if(0 >= in_hz || 0 >= out_hz || 0 >= nch || 0 >= max_in){
+        return -1;
+    }
+
+    const int g = gcd(in_hz, out_hz);
+    const int up = out_hz / g;
+    const int down = in_hz / g;
+
+    /* --- Filter length and cutoff, in input samples --- */
+
+    const double ratio = (double)up / down;
+    const double fc = RESAMPLE_CUTOFF * (ratio < 1 ? ratio : 1);
+    const int half = (int)ceil(RESAMPLE_ZEROS / fc);
+    const int ntaps = (2 * half + RESAMPLE_ALIGN - 1) & ~(RESAMPLE_ALIGN - 1);
+
+    *rs = (resampler_t){
+        .nch = nch,
+        .up = up,
+        .down = down,
+        .ntaps = ntaps,
+        .pos = (int64_t)(ntaps/2 - 1) * up,
+        .nx = ntaps/2 - 1,
+        .xsiz = ntaps + max_in,
+    };
+
+    rs->h = malloc((size_t)up * ntaps * sizeof(float));
+    rs->x = calloc((size_t)nch * rs->xsiz, sizeof(float));
+    if(NULL == rs->h || NULL == rs->x){
+        resampler_free(rs);
+        return -1;
+    }
+
+    /* --- Windowed sinc, sampled at each phase ---
+     * The phase `p` outputs at `p / up` after the input `ntaps/2 - 1`,
+     * each phase is normalized to an unity gain. */
+
+    const double i0_beta = bessel_i0(RESAMPLE_BETA);
+
+    for (int p = 0; p < up; p++){
+        float * const h = rs->h + (size_t)p * ntaps;
+        double sum = 0;
+
+        for (int k = 0; k < ntaps; k++){
+            const double d = (k - (ntaps/2 - 1)) - (double)p / up;
+            const double w = d / (ntaps / 2);
+            const double a = M_PI * fc * d;
+
+            double v = (0 == d) ? fc : fc * sin(a) / a;
+            v *= (w * w < 1) ?
+                bessel_i0(RESAMPLE_BETA * sqrt(1 - w * w)) / i0_beta : 0;
+
+            h[k] = v;
+            sum += v;
+        }
+
+        const float g = 1 / sum;
+        for (int k = 0; k < ntaps; k++){
+            h[k] *= g;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief release the memory of a resampler
+*/
+void resampler_free(resampler_t * const rs)
+{
+    free(rs->h);
+    free(rs->x);
+    rs->h = NULL;
+    rs->x = NULL;
+}
+
+/**
+ * @brief return the number of input samples needed to output 'nout' ones
+*/
+int resampler_needed(const resampler_t * const rs,
+                     const int nout)
+{
+    if(0 >= nout){
+        return 0;
+    }
+
+    const int64_t pos = rs->pos + (int64_t)(nout - 1) * rs->down;
+    const int64_t n = pos / rs->up + rs->ntaps/2 + 1 - rs->nx;
+
+    return n > 0 ? n : 0;
+}
+
+/**
+ * dot product of the phase of a filter, with the input samples
+*/
+static inline
+float dot(const float * const h, const float * const x, const int n)
+{
+    float sum = 0;
+
+    for (int k = 0; k < n; k++){
+        sum += h[k] * x[k];
+    }
+
+    return sum;
+}
+
+/**
+ * load interleaved PCM samples of a channel, as float in range -1 to 1
+*/
+static
+void load(const enum lc3_pcm_format fmt,
+          const void * const pcm,
+          const int stride,
+          const int n,
+          float * const x)
+{
+    const int16_t * const p16 = pcm;
+    const int32_t * const p32 = pcm;
+    const uint8_t * const p8 = pcm;
+    const float * const pf = pcm;
+
+    for (int i = 0; i < n; i++){
+        const int k = i * stride;
+
+        switch(fmt){
+        case LC3_PCM_FORMAT_S24:
+            x[i] = ldexpf(p32[k], -23);
+            break;
+
+        case LC3_PCM_FORMAT_S24_3LE:
+            x[i] = ldexpf((int32_t)((uint32_t)p8[3*k+0] <<  8 |
+                                    (uint32_t)p8[3*k+1] << 16 |
+                                    (uint32_t)p8[3*k+2] << 24) >> 8, -23);
+            break;
+
+        case LC3_PCM_FORMAT_FLOAT:
+            x[i] = pf[k];
+            break;
+
+        default:
+            x[i] = ldexpf(p16[k], -15);
+            break;
+        }
+    }
+}
+
+
+/**
+ * @brief resample interleaved samples, the state is carried over runs
+ *
+ * @return number of output samples, by channel
+*/
+int resampler_run(resampler_t * const rs,
+                  const enum lc3_pcm_format fmt,
+                  const void * const in,
+                  const int nin,
+                  float * const out,
+                  const int max_out)
+{
+    const int nch = rs->nch;
+    const int up = rs->up;
+    const int ntaps = rs->ntaps;
+
+    if(0 > nin || rs->nx + nin > rs->xsiz){
+        return 0;
+    }
+
+    /* --- Buffer the input, by channel --- */
+
+    for (int ch = 0; ch < nch; ch++){
+        load(fmt, (const uint8_t *)in + ch * pcm_sbytes[fmt], nch, nin,
+             rs->x + (size_t)ch * rs->xsiz + rs->nx);
+    }
+
+    rs->nx += nin;
+
+    /* --- Output while the lookahead is available --- */
+
+    int nout = 0;
+
+    for ( ; nout < max_out && rs->pos / up + ntaps/2 < rs->nx;
+            rs->pos += rs->down, nout++){
+        const int i0 = rs->pos / up - (ntaps/2 - 1);
+        const float * const h = rs->h + (size_t)(rs->pos % up) * ntaps;
+
+        for (int ch = 0; ch < nch; ch++){
+            out[nout * nch + ch] =
+                dot(h, rs->x + (size_t)ch * rs->xsiz + i0, ntaps);
+        }
+    }
+
+    /* --- Keep the history of the next output --- */
+
+    const int drop = rs->pos / up - (ntaps/2 - 1);
+
+    for (int ch = 0; ch < nch; ch++){
+        float * const x = rs->x + (size_t)ch * rs->xsiz;
+        memmove(x, x + drop, (rs->nx - drop) * sizeof(float));
+    }
+
+    rs->nx -= drop;
+    rs->pos -= (int64_t)drop * up;
+
+    return nout;
+}
+
+/**
+ * @brief convert float samples, in range -1 to 1, to PCM samples
+*/
+void resample_to_pcm(const enum lc3_pcm_format fmt,
+                     const float * const x,
+                     const int n,
+                     void * const pcm)
+{
+    int16_t * const p16 = pcm;
+    int32_t * const p32 = pcm;
+    uint8_t * const p8 = pcm;
+
+    const int nbits = (LC3_PCM_FORMAT_S16 == fmt) ? 16 : 24;
+    const float smax = ldexpf(1, nbits - 1) - 1;
+    const float smin = -ldexpf(1, nbits - 1);
+
+    for (int i = 0; i < n; i++){
+        if(LC3_PCM_FORMAT_FLOAT == fmt){
+            ((float *)pcm)[i] = fminf(fmaxf(x[i], -1.f), 1.f);
+            continue;
+        }
+
+        const float v = fminf(fmaxf(
+            roundf(ldexpf(x[i], nbits - 1)), smin), smax);
+        const int32_t s = v;
+
+        switch(fmt){
+        case LC3_PCM_FORMAT_S24:
+            p32[i] = s;
+            break;
+
+        case LC3_PCM_FORMAT_S24_3LE:
+            p8[3*i+0] = (s >>  0) & 0xff;
+            p8[3*i+1] = (s >>  8) & 0xff;
+            p8[3*i+2] = (s >> 16) & 0xff;
+            break;
+
+        default:
+            p16[i] = s;
+            break;
+        }
+    }
+}
+
+/**
+ * @brief init the resampling of the frames of a coder
+*/
+int resample_coder_init(resample_coder_t * const rc,
+                        const int in_hz,
+                        const int out_hz,
+                        const int nch,
+                        const enum lc3_pcm_format fmt,
+                        const int max_in)
+{
+    *rc = (resample_coder_t){ .fmt = fmt };
+
+    if(0 != resampler_init(&rc->rs, in_hz, out_hz, nch, max_in)){
+        return -1;
+    }
+
+    /* the PCM samples are read with the lookahead of the filter,
+     * or written as output, the largest of both is allocated */
+    rc->max_out = ((int64_t)max_in * out_hz) / in_hz + 2;
+    const int npcm = rc->rs.xsiz > rc->max_out ? rc->rs.xsiz : rc->max_out;
+
+    rc->pcm = malloc((size_t)npcm * nch * pcm_sbytes[fmt]);
+    rc->x = malloc((size_t)rc->max_out * nch * sizeof(float));
+    if(NULL == rc->pcm || NULL == rc->x){
+        resample_coder_free(rc);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief release the memory of the resampling of a coder
+*/
+void resample_coder_free(resample_coder_t * const rc)
+{
+    resampler_free(&rc->rs);
+    free(rc->pcm);
+    free(rc->x);
+    rc->pcm = NULL;
+    rc->x = NULL;
+}
+
+/**
+ * @brief resample the PCM samples read in 'pcm', to the float ones of 'x'
+*/
+const float * resample_coder_from_pcm(resample_coder_t * const rc,
+                                      const int nin,
+                                      const int nout)
+{
+    resampler_run(&rc->rs, rc->fmt, rc->pcm, nin, rc->x,
+                  nout < rc->max_out ? nout : rc->max_out);
+
+    return rc->x;
+}
+
+/**
+ * @brief resample float samples, to the PCM ones of 'pcm'
+*/
+int resample_coder_to_pcm(resample_coder_t * const rc,
+                          const float * const x,
+                          const int nin,
+                          const int max_out)
+{
+    const int nout = resampler_run(&rc->rs, LC3_PCM_FORMAT_FLOAT, x, nin,
+                                   rc->x, rc->max_out);
+    const int n = nout < max_out ? nout : max_out;
+
+    resample_to_pcm(rc->fmt, rc->x, rc->rs.nch * n, rc->pcm);
+
+    return n;
+}
@@ -19,6 +19,8 @@
 #include "sns.h"
 #include "tables.h"
 
+#include "sns_sse.h"
+
 
 /* ----------------------------------------------------------------------------
  *  DCT-16
@@ -120,6 +122,8 @@ static const float dct16_m[16][16] = {
  * Forward DCT-16 transformation
  * x, y            Input and output 16 values
  */
+#ifndef dct16_forward
+
 LC3_HOT static void dct16_forward(const float *x, float *y)
 {
     for (int i = 0, j; i < 16; i++)
@@ -127,10 +131,14 @@ LC3_HOT static void dct16_forward(const float *x, float *y)
             y[i] += x[j] * dct16_m[j][i];
 }
 
+#endif /* dct16_forward */
+
 /**
  * Inverse DCT-16 transformation
  * x, y            Input and output 16 values
  */
+#ifndef dct16_inverse
+
 LC3_HOT static void dct16_inverse(const float *x, float *y)
 {
     for (int i = 0, j; i < 16; i++)
@@ -138,6 +146,8 @@ LC3_HOT static void dct16_inverse(const float *x, float *y)
             y[i] += x[j] * dct16_m[i][j];
 }
 
+#endif /* dct16_inverse */
+
 
 /* ----------------------------------------------------------------------------
  *  Scale factors
@@ -344,6 +354,8 @@ LC3_HOT static void compute_scale_factors(
  * scf             Input 16 scale factors
  * lf/hfcb_idx     Output the low and high frequency codebooks index
  */
+#ifndef resolve_codebooks
+
 LC3_HOT static void resolve_codebooks(
     const float *scf, int *lfcb_idx, int *hfcb_idx)
 {
@@ -368,6 +380,8 @@ LC3_HOT static void resolve_codebooks(
     }
 }
 
+#endif /* resolve_codebooks */
+
 /**
  * Unit energy normalize pulse configuration
  * c               Pulse configuration
@@ -413,6 +427,49 @@ LC3_HOT static void add_pulse(const float *x, int *y, int n,
     }
 }
 
+/**
+ * Sub-procedure of `quantize()`, selection of the shape and gain
+ * x               Transformed residual
+ * cn              The 4 normalized pulse configurations candidates
+ * shape/gain_idx  Output selected shape/gain indexes
+ *
+ * Search the Mean Square Error, within (shape, gain) combinations
+ */
+#ifndef search_shape_gain
+
+LC3_HOT static void search_shape_gain(const float *x,
+    float (*cn)[16], int *shape_idx, int *gain_idx)
+{
+    float mse_min = INFINITY;
+    *shape_idx = *gain_idx = 0;
+
+    for (int ic = 0; ic < 4; ic++) {
+        const struct lc3_sns_vq_gains *cgains = lc3_sns_vq_gains + ic;
+        float cmse_min = INFINITY;
+        int cgain_idx = 0;
+
+        for (int ig = 0; ig < cgains->count; ig++) {
+            float g = cgains->v[ig];
+
+            float mse = 0;
+            for (int i = 0; i < 16; i++)
+                mse += (x[i] - g * cn[ic][i]) * (x[i] - g * cn[ic][i]);
+
+            if (mse < cmse_min) {
+                cgain_idx = ig,
+                cmse_min = mse;
+            }
+        }
+
+        if (cmse_min < mse_min) {
+            *shape_idx = ic, *gain_idx = cgain_idx;
+            mse_min = cmse_min;
+        }
+    }
+}
+
+#endif /* search_shape_gain */
+
 /**
  * Quantization of codebooks residual
  * scf             Input 16 scale factors, output quantized version
@@ -503,35 +560,9 @@ LC3_HOT static void quantize(const float *scf, int lfcb_idx, int hfcb_idx,
     for (int i = 0; i < 4; i++)
         normalize(c[i], cn[i]);
 
-    /* --- Determe shape & gain index ---
-     * Search the Mean Square Error, within (shape, gain) combinations */
-
-    float mse_min = INFINITY;
-    *shape_idx = *gain_idx = 0;
-
-    for (int ic = 0; ic < 4; ic++) {
-        const struct lc3_sns_vq_gains *cgains = lc3_sns_vq_gains + ic;
-        float cmse_min = INFINITY;
-        int cgain_idx = 0;
-
-        for (int ig = 0; ig < cgains->count; ig++) {
-            float g = cgains->v[ig];
+    /* --- Determe shape & gain index --- */
 
-            float mse = 0;
-            for (int i = 0; i < 16; i++)
-                mse += (x[i] - g * cn[ic][i]) * (x[i] - g * cn[ic][i]);
-
-            if (mse < cmse_min) {
-                cgain_idx = ig,
-                cmse_min = mse;
-            }
-        }
-
-        if (cmse_min < mse_min) {
-            *shape_idx = ic, *gain_idx = cgain_idx;
-            mse_min = cmse_min;
-        }
-    }
+    search_shape_gain(x, cn, shape_idx, gain_idx);
 }
 
 /**
@@ -20,6 +20,8 @@
 #include "bits.h"
 #include "tables.h"
 
+#include "spec_sse.h"
+
 
 /* ----------------------------------------------------------------------------
  *  Global Gain / Quantization
@@ -36,6 +38,59 @@ static int resolve_gain_offset(enum lc3_srate sr, int nbytes)
     return 105 + 5*(1 + sr) + LC3_MIN(g_off, 115);
 }
 
+/**
+ * Energy (dB) by blocks of 4 MDCT coefficients
+ * x, n            Spectral coefficients, and count of blocks
+ * e               Output the energies in dB, in fixed Q16
+ * return          The maximum square of the coefficients
+ */
+#ifndef compute_energy_db
+LC3_HOT static float compute_energy_db(const float *x, int n, int *e)
+{
+    float x2_max = 0;
+
+    for (int i = 0; i < n; i++, x += 4) {
+        float x0 = x[0] * x[0];
+        float x1 = x[1] * x[1];
+        float x2 = x[2] * x[2];
+        float x3 = x[3] * x[3];
+
+        x2_max = fmaxf(x2_max, x0);
+        x2_max = fmaxf(x2_max, x1);
+        x2_max = fmaxf(x2_max, x2);
+        x2_max = fmaxf(x2_max, x3);
+
+        e[i] = fast_db_q16(fmaxf(x0 + x1 + x2 + x3, 1e-10f));
+    }
+
+    return x2_max;
+}
+#endif /* compute_energy_db */
+
+/**
+ * Cost in bits of the energies, for a gain
+ * e, n            Energies in dB, in fixed Q16, and count
+ * gn              Gain in dB, in fixed Q16
+ * return          Estimated bits, scaled by 1.4 in fixed Q16
+ */
+#ifndef compute_gain_cost
+LC3_HOT static int compute_gain_cost(const int *e, int n, int gn)
+{
+    const int k_2u7 = 2.7f * 0x1p16f + 0.5f;
+    int v = 0;
+
+    for (int j = n-1; j >= 0; j--) {
+        int e_diff = e[j] - gn;
+
+        v += e_diff < 0 ? k_2u7 :
+             e_diff < 43 << 16 ?   e_diff + ( 7 << 16)
+                               : 2*e_diff - (36 << 16);
+    }
+
+    return v;
+}
+#endif /* compute_gain_cost */
+
 /**
  * Global Gain Estimation
  * dt, sr          Duration and samplerate of the frame
@@ -56,21 +111,7 @@ LC3_HOT static int estimate_gain(
 
     /* --- Energy (dB) by 4 MDCT blocks --- */
 
-    float x2_max = 0;
-
-    for (int i = 0; i < ne; i++, x += 4) {
-        float x0 = x[0] * x[0];
-        float x1 = x[1] * x[1];
-        float x2 = x[2] * x[2];
-        float x3 = x[3] * x[3];
-
-        x2_max = fmaxf(x2_max, x0);
-        x2_max = fmaxf(x2_max, x1);
-        x2_max = fmaxf(x2_max, x2);
-        x2_max = fmaxf(x2_max, x3);
-
-        e[i] = fast_db_q16(fmaxf(x0 + x1 + x2 + x3, 1e-10f));
-    }
+    float x2_max = compute_energy_db(x, ne, e);
 
     /* --- Determine gain index --- */
 
@@ -78,22 +119,14 @@ LC3_HOT static int estimate_gain(
     int g_int = 255 - g_off;
 
     const int k_20_28 = 20.f/28 * 0x1p16f + 0.5f;
-    const int k_2u7 = 2.7f * 0x1p16f + 0.5f;
     const int k_1u4 = 1.4f * 0x1p16f + 0.5f;
 
-    for (int i = 128, j, j0 = ne-1, j1 ; i > 0; i >>= 1) {
+    for (int i = 128, j0 = ne-1, j1 ; i > 0; i >>= 1) {
         int gn = (g_int - i) * k_20_28;
-        int v = 0;
 
-        for (j = j0; j >= 0 && e[j] < gn; j--);
+        for (j1 = j0; j1 >= 0 && e[j1] < gn; j1--);
 
-        for (j1 = j; j >= 0; j--) {
-            int e_diff = e[j] - gn;
-
-            v += e_diff < 0 ? k_2u7 :
-                 e_diff < 43 << 16 ?   e_diff + ( 7 << 16)
-                                   : 2*e_diff - (36 << 16);
-        }
+        int v = compute_gain_cost(e, j1 + 1, gn);
 
         if (v > nbits * k_1u4)
             j0 = j1;
@@ -207,6 +240,7 @@ static float unquantize_gain(int g_int)
  *   b0       0:positive or zero  1:negative
  *   b15..b1  Absolute value
  */
+#ifndef quantize
 LC3_HOT static void quantize(enum lc3_dt dt, enum lc3_srate sr,
     int g_int, float *x, uint16_t *xq, int *nq)
 {
@@ -230,6 +264,7 @@ LC3_HOT static void quantize(enum lc3_dt dt, enum lc3_srate sr,
         *nq = x0 || x1 ? ne : *nq - 2;
     }
 }
+#endif /* quantize */
 
 /**
  * Spectrum quantization inverse
@@ -268,6 +303,35 @@ static int resolve_high_rate(enum lc3_srate sr, int nbytes)
     return nbytes > 20 * (1 + (int)sr);
 }
 
+/**
+ * Bit consumption of a count, kept for a new count of the frame
+ * n               Count of significant coefficients
+ * x               Spectral quantized coefficients counted
+ * nbits           Cumulated bits until each tuple, in fixed Q11
+ * nbits_lsb       Cumulated bits of the LSB's not arithmetic coded
+ */
+struct nbits_count {
+    int n;
+    uint16_t x[LC3_MAX_NE];
+    int nbits[LC3_MAX_NE/2], nbits_lsb[LC3_MAX_NE/2];
+};
+
+/**
+ * Locate the identical tail of 2 sets of quantized coefficients
+ * x, y, n         Spectral quantized coefficients, and count
+ * return          Index of the first coefficient of the identical tail
+ */
+#ifndef locate_common_tail
+LC3_HOT static int locate_common_tail(
+    const uint16_t *x, const uint16_t *y, int n)
+{
+    while (n > 0 && x[n-2] == y[n-2] && x[n-1] == y[n-1])
+        n -= 2;
+
+    return n;
+}
+#endif /* locate_common_tail */
+
 /**
  * Bit consumption
  * dt, sr, nbytes  Duration, samplerate and size of the frame
@@ -275,15 +339,22 @@ static int resolve_high_rate(enum lc3_srate sr, int nbytes)
  * n               Count of significant coefficients, updated on truncation
  * nbits_budget    Truncate to stay in budget, when not zero
  * p_lsb_mode      Return True when LSB's are not AC coded, or NULL
+ * prev            Previous count of the frame, or NULL
+ * save            Output the count, or NULL
  * return          The number of bits coding the spectrum
  *
  * The spectral coefficients `x` storage is :
  *   b0       0:positive or zero  1:negative
  *   b15..b1  Absolute value
+ *
+ * The context of a tuple is given by the 2 previous ones. Following
+ * 2 tuples unchanged from the previous count, the bits of the remaining
+ * unchanged tuples are taken from the previous count.
  */
 LC3_HOT static int compute_nbits(
     enum lc3_dt dt, enum lc3_srate sr, int nbytes,
-    const uint16_t *x, int *n, int nbits_budget, bool *p_lsb_mode)
+    const uint16_t *x, int *n, int nbits_budget, bool *p_lsb_mode,
+    const struct nbits_count *prev, struct nbits_count *save)
 {
     int ne = LC3_NE(dt, sr);
 
@@ -292,6 +363,18 @@ LC3_HOT static int compute_nbits(
     bool lsb_mode  = nbytes >= 20 * (3 + (int)sr);
     bool high_rate = resolve_high_rate(sr, nbytes);
 
+    /* --- Unchanged tail from the previous count --- */
+
+    int i_tail = ne + 2;
+
+    if (prev && prev->n == *n && *n > 0)
+        i_tail = locate_common_tail(prev->x, x, *n) + 4;
+
+    if (save) {
+        save->n = *n;
+        memcpy(save->x, x, *n * sizeof(*x));
+    }
+
     /* --- Loop on quantized coefficients --- */
 
     int nbits = 0, nbits_lsb = 0;
@@ -308,6 +391,21 @@ LC3_HOT static int compute_nbits(
         for ( ; i < LC3_MIN(*n, (ne + 2) >> (1 - h))
                 && nbits <= nbits_budget; i += 2) {
 
+            /* --- Take the bits of the unchanged tail,
+             *     when it does not overflow the budget --- */
+
+            if (i == i_tail) {
+                int t0 = (i >> 1) - 1, t1 = (*n >> 1) - 1;
+                int nbits_tail = nbits + prev->nbits[t1] - prev->nbits[t0];
+
+                if (nbits_tail <= nbits_budget) {
+                    nbits_lsb += prev->nbits_lsb[t1] - prev->nbits_lsb[t0];
+                    nbits = nbits_end = nbits_tail;
+                    n_end = i = *n;
+                    break;
+                }
+            }
+
             const uint8_t *lut = lut_coeff[state];
             uint16_t a = x[i] >> 1, b = x[i+1] >> 1;
 
@@ -346,6 +444,11 @@ LC3_HOT static int compute_nbits(
 
             nbits += lc3_spectrum_bits[lut[k]][a + 4*b];
 
+            if (save) {
+                save->nbits[i >> 1] = nbits;
+                save->nbits_lsb[i >> 1] = nbits_lsb;
+            }
+
             /* --- Update state --- */
 
             if (s && nbits <= nbits_budget) {
@@ -463,8 +566,7 @@ LC3_HOT static int get_quantized(lc3_bits_t *bits,
 {
     int ne = LC3_NE(dt, sr);
     bool high_rate = resolve_high_rate(sr, nbytes);
-
-     *nf_seed = 0;
+    unsigned seed = 0;
 
     /* --- Loop on quantized coefficients --- */
 
@@ -479,7 +581,7 @@ LC3_HOT static int get_quantized(lc3_bits_t *bits,
 
             /* --- LSB values ---
              * Until the symbol read indicates the escape value 16,
-             * read an LSB bit for each values.
+             * read an LSB bit for each values, as a pair of bits.
              * The LSB mode discard the first LSB (at this step) */
 
             int u = 0, v = 0;
@@ -493,8 +595,9 @@ LC3_HOT static int get_quantized(lc3_bits_t *bits,
             }
 
             for ( ; s >= 16 && shl < 14; shl++) {
-                u |= lc3_get_bit(bits) << shl;
-                v |= lc3_get_bit(bits) << shl;
+                unsigned uv = lc3_get_bits(bits, 2);
+                u |= (uv & 1) << shl;
+                v |= (uv >> 1) << shl;
 
                 k += (k < 3);
                 s  = lc3_get_symbol(bits, lc3_spectrum_models + lut[k]);
@@ -514,7 +617,7 @@ LC3_HOT static int get_quantized(lc3_bits_t *bits,
             xq[i  ] = u && lc3_get_bit(bits) ? -u : u;
             xq[i+1] = v && lc3_get_bit(bits) ? -v : v;
 
-            *nf_seed = (*nf_seed + u * i + v * (i+1)) & 0xffff;
+            seed += u * i + v * (i+1);
 
             /* --- Update state --- */
 
@@ -522,6 +625,7 @@ LC3_HOT static int get_quantized(lc3_bits_t *bits,
         }
     }
 
+    *nf_seed = seed & 0xffff;
     return 0;
 }
 
@@ -768,7 +872,7 @@ static int get_nbits_ac(enum lc3_dt dt, enum lc3_srate sr, int nbytes)
  * Spectrum analysis
  */
 void lc3_spec_analyze(enum lc3_dt dt, enum lc3_srate sr,
-    int nbytes, bool pitch, const lc3_tns_data_t *tns,
+    int nbytes, bool pitch, const lc3_tns_data_t *tns, bool adjust,
     struct lc3_spec_analysis *spec, float *x,
     uint16_t *xq, struct lc3_spec_side *side)
 {
@@ -796,24 +900,44 @@ void lc3_spec_analyze(enum lc3_dt dt, enum lc3_srate sr,
 
     /* --- Quantization --- */
 
+    struct nbits_count count;
+
     quantize(dt, sr, g_int, x, xq, &side->nq);
 
-    int nbits = compute_nbits(dt, sr, nbytes, xq, &side->nq, 0, NULL);
+    int nbits = compute_nbits(dt, sr, nbytes,
+        xq, &side->nq, 0, NULL, NULL, &count);
 
     spec->nbits_off = reset_off ? 0 : nbits_off;
     spec->nbits_spare = reset_off ? 0 : nbits_budget - nbits;
 
+    /* --- Without adjustment, the spectrum is kept while in budget --- */
+
+    if (!adjust && nbits <= nbits_budget) {
+        side->g_idx = g_int + g_off;
+        side->lsb_mode = false;
+        return;
+    }
+
     /* --- Adjust gain and requantize --- */
 
     int g_adj = adjust_gain(sr, g_off + g_int,
         nbits, nbits_budget, g_off + g_min);
 
+    side->g_idx = g_int + g_adj + g_off;
+
+    /* --- The count is kept when the gain is not changed, and the
+     *     spectrum is in budget, without truncation nor LSB mode --- */
+
+    if (!g_adj && nbits <= nbits_budget) {
+        side->lsb_mode = false;
+        return;
+    }
+
     if (g_adj)
         quantize(dt, sr, g_adj, x, xq, &side->nq);
 
-    side->g_idx = g_int + g_adj + g_off;
     nbits = compute_nbits(dt, sr, nbytes,
-        xq, &side->nq, nbits_budget, &side->lsb_mode);
+        xq, &side->nq, nbits_budget, &side->lsb_mode, &count, NULL);
 }
 
 /**
@@ -873,30 +997,67 @@ int lc3_spec_get_side(lc3_bits_t *bits,
 }
 
 /**
- * Decode spectral coefficients
+ * Get quantized spectral coefficients, and noise factor
+ * bits            Bitstream context
+ * dt, sr, nbytes  Duration, samplerate and size of the frame
+ * side            Quantization side data
+ * x               Return the quantized coefficients
+ * nf, nf_seed     Return the noise factor, and the pseudo-random seed
+ * return          0: Ok  -1: Invalid bitstream data
  */
-int lc3_spec_decode(lc3_bits_t *bits,
-    enum lc3_dt dt, enum lc3_srate sr, enum lc3_bandwidth bw,
-    int nbytes, const lc3_spec_side_t *side, float *x)
+static int get_spectrum(lc3_bits_t *bits,
+    enum lc3_dt dt, enum lc3_srate sr, int nbytes,
+    const lc3_spec_side_t *side, float *x, int *nf, uint16_t *nf_seed)
 {
     bool lsb_mode = side->lsb_mode;
     int nq = side->nq;
     int ret = 0;
 
-    int nf = get_noise_factor(bits);
-    uint16_t nf_seed;
+    *nf = get_noise_factor(bits);
 
     if ((ret = get_quantized(bits, dt, sr, nbytes,
-                    nq, lsb_mode, x, &nf_seed)) < 0)
+                    nq, lsb_mode, x, nf_seed)) < 0)
         return ret;
 
     int nbits_left = lc3_get_bits_left(bits);
 
     if (lsb_mode)
-        get_lsb(bits, nbits_left, x, nq, &nf_seed);
+        get_lsb(bits, nbits_left, x, nq, nf_seed);
     else
         get_residual(bits, nbits_left, x, nq);
 
+    return 0;
+}
+
+/**
+ * Parse spectral coefficients
+ */
+int lc3_spec_parse(lc3_bits_t *bits,
+    enum lc3_dt dt, enum lc3_srate sr, int nbytes,
+    const lc3_spec_side_t *side, float *x, int *nf)
+{
+    uint16_t nf_seed;
+
+    return get_spectrum(bits, dt, sr, nbytes, side, x, nf, &nf_seed);
+}
+
+/**
+ * Decode spectral coefficients
+ */
+int lc3_spec_decode(lc3_bits_t *bits,
+    enum lc3_dt dt, enum lc3_srate sr, enum lc3_bandwidth bw,
+    int nbytes, const lc3_spec_side_t *side, float *x)
+{
+    int nq = side->nq;
+    int ret = 0;
+
+    int nf;
+    uint16_t nf_seed;
+
+    if ((ret = get_spectrum(bits, dt, sr, nbytes,
+                    side, x, &nf, &nf_seed)) < 0)
+        return ret;
+
     int g_int = side->g_idx - resolve_gain_offset(sr, nbytes);
     float g = unquantize(dt, sr, g_int, x, nq);
 
@@ -10,6 +10,7 @@
 #include "wave.h"
 #include "bytestream.h"
 #include "lc3bin.h"
+#include "resample.h"
 #include "log.h"
 
 static
@@ -94,17 +95,33 @@ ilc3_res_t stream_to_lc3(ilc3_coder_t * const encoder,
         return ILC3_BAD_INOUT;
     }
 
+    if (!ILC3_CHECK_SR_HZ(srate_hz)){
+        ERROR("not suported samplerate %d\n", srate_hz);
+        return ILC3_BAD_ARG;
+    }
+
     int enc_srate_hz = 0;
     int enc_samples = 0;
     const int encoder_srate = encoder->srate_hz;
-    if(0 == encoder_srate){
-        enc_srate_hz = srate_hz;
-        enc_samples = nsamples;
+    if(0 == encoder_srate || !LC3_CHECK_SR_HZ(encoder_srate)){
+        enc_srate_hz = resample_lc3_hz(srate_hz);
     } else {
         enc_srate_hz = encoder_srate;
+    }
+
+    /* samplerates the encoder can't downsample itself are resampled to the
+     * samplerate of the encoder, or by default to the closest higher LC3 one */
+    const bool resample = !resample_lc3_native(enc_srate_hz, srate_hz) ||
+                          enc_srate_hz > srate_hz;
+    if(enc_srate_hz == srate_hz){
+        enc_samples = nsamples;
+    } else {
         enc_samples = ((int64_t)nsamples * enc_srate_hz) / srate_hz;
     }
 
+    const int pcm_srate_hz = resample ? enc_srate_hz : srate_hz;
+    const int pcm_samples = resample ? enc_samples : nsamples;
+
     bstream_t f_out;
     bstream_t * const fp_out = &f_out;
     const int bout_init_res = binit(fp_out, fout, out_siz, BM_WRITE);
@@ -132,58 +149,102 @@ ilc3_res_t stream_to_lc3(ilc3_coder_t * const encoder,
     uint8_t out[2 * LC3_MAX_FRAME_BYTES];
     lc3_encoder_t enc[2];
 
-    const int frame_bytes = lc3_frame_bytes(frame_us, bitrate / nch);
-    const int frame_samples = lc3_frame_samples(frame_us, srate_hz);
-    const int encode_samples = nsamples + lc3_delay_samples(frame_us, srate_hz);
+    const int frame_bytes = lc3_frame_bytes_ex(frame_us, enc_srate_hz, bitrate / nch);
+    const int frame_samples = lc3_frame_samples(frame_us, pcm_srate_hz);
+    const int encode_samples = pcm_samples + lc3_delay_samples(frame_us, pcm_srate_hz);
     const enum lc3_pcm_format pcm_fmt =
         pcm_sbytes == 32/8 ? LC3_PCM_FORMAT_S24 :
         pcm_sbytes == 24/8 ? LC3_PCM_FORMAT_S24_3LE : LC3_PCM_FORMAT_S16;
 
-    const uint32_t encoder_size = lc3_encoder_size(frame_us, srate_hz);
+    /* the resampled frames are read in the buffer of the resampler,
+     * and given to the encoder as float samples */
+    resample_coder_t rc = { 0 };
+    if(resample){
+        const int frame_in = ((int64_t)frame_samples * srate_hz) / pcm_srate_hz + 1;
+        if(0 != resample_coder_init(&rc, srate_hz, pcm_srate_hz, nch, pcm_fmt, frame_in)){
+            ERROR("can't init resampler\n");
+            return ILC3_BAD_ARG;
+        }
+    }
+
+    const uint32_t encoder_size = lc3_encoder_size(frame_us, pcm_srate_hz);
     for (int ich = 0; ich < nch; ich++){
         enc[ich] = lc3_setup_encoder(frame_us,
                                      enc_srate_hz,
-                                     srate_hz,
-                                     malloc(encoder_size));
+                                     pcm_srate_hz,
+                                     lc3_pool_get(encoder->pool,
+                                                  encoder_size));
     }
 
     
     /* --- Encoding loop --- */
 
-    for (int i = 0; i * frame_samples < encode_samples; i++) {
-        int nread = bread((uint8_t*)pcm, nch * pcm_sbytes, frame_samples, fp_in);
+    int64_t nconsumed = 0;
+    ilc3_res_t res = ILC3_OK;
+
+    for (int ich = 0; ich < nch; ich++){
+        if(NULL == enc[ich]){
+            ERROR("can't setup encoder\n");
+            res = ILC3_BAD_ARG;
+        }
+    }
+
+    for (int i = 0; ILC3_OK == res && i * frame_samples < encode_samples; i++) {
+        const int nin = resample ?
+            resampler_needed(&rc.rs, frame_samples) : frame_samples;
+        int8_t * const in = resample ? rc.pcm : pcm;
+
+        int nread = nin ? bread((uint8_t*)in, nch * pcm_sbytes, nin, fp_in) : 0;
+        if(-2 == nread && nconsumed >= nsamples){
+            /* the delay of the codec is flushed after the end of input */
+            nread = 0;
+        }
         if(0 > nread){
             ERROR("in bstream not enought data\n");
-            for (int ich = 0; ich < nch; ich++){
-                free(enc[ich]);
-            }
-            return ILC3_BAD_INOUT;
+            res = ILC3_BAD_INOUT;
+            break;
         }
 
-        memset(pcm + nread * nch * pcm_sbytes, 0,
-            nch * (frame_samples - nread) * pcm_sbytes);
+        nconsumed += nread;
+        memset(in + nread * nch * pcm_sbytes, 0,
+            nch * (nin - nread) * pcm_sbytes);
+
+        const float * const rs_out = resample ?
+            resample_coder_from_pcm(&rc, nin, frame_samples) : NULL;
 
         for (int ich = 0; ich < nch; ich++){
-            lc3_encode(enc[ich],
-                       pcm_fmt,
-                       pcm + ich * pcm_sbytes, nch,
-                       frame_bytes,
-                       out + ich * frame_bytes);
+            if(resample){
+                lc3_encode(enc[ich],
+                           LC3_PCM_FORMAT_FLOAT,
+                           rs_out + ich, nch,
+                           frame_bytes,
+                           out + ich * frame_bytes);
+            } else {
+                lc3_encode(enc[ich],
+                           pcm_fmt,
+                           pcm + ich * pcm_sbytes, nch,
+                           frame_bytes,
+                           out + ich * frame_bytes);
+            }
         }
 
         const int wres = lc3bin_bwrite_data(fp_out, out, nch, frame_bytes);
         if(0 != wres){
             ERROR("in bstream not enought space\n");
-            for (int ich = 0; ich < nch; ich++){
-                free(enc[ich]);
-            }
-            return ILC3_BAD_INOUT;
+            res = ILC3_BAD_INOUT;
+            break;
         }
     }
     /* --- Cleanup --- */
 
     for (int ich = 0; ich < nch; ich++){
-        free(enc[ich]);
+        lc3_pool_put(encoder->pool, enc[ich]);
+    }
+
+    resample_coder_free(&rc);
+
+    if(ILC3_OK != res){
+        return res;
     }
 
     return ILC3_OK + (out_siz - fp_out->bsiz);
@@ -222,7 +283,7 @@ ilc3_res_t lc3_to_stream(ilc3_coder_t * const decoder,
     }
 
     const int dstate_hz = decoder->srate_hz;
-    if (!LC3_CHECK_SR_HZ(srate_hz) || (dstate_hz && dstate_hz < srate_hz)){
+    if (!LC3_CHECK_SR_HZ(srate_hz) || (dstate_hz && !ILC3_CHECK_SR_HZ(dstate_hz))){
         return ILC3_BAD_ARG;
     }
 
@@ -233,6 +294,11 @@ ilc3_res_t lc3_to_stream(ilc3_coder_t * const decoder,
     int pcm_samples = !dstate_hz ? nsamples :
         ((int64_t)nsamples * pcm_srate_hz) / srate_hz;
 
+    /* samplerates the decoder can't give itself are resampled from the
+     * closest higher LC3 samplerate, the stream one when lower */
+    const int dec_srate_hz = resample_dec_hz(srate_hz, pcm_srate_hz);
+    const bool resample = dec_srate_hz != pcm_srate_hz;
+
     bstream_t f_out;
     bstream_t * const fp_out = &f_out;
     const int bout_init_res = binit(fp_out, fout, out_siz, BM_WRITE);
@@ -259,55 +325,234 @@ ilc3_res_t lc3_to_stream(ilc3_coder_t * const decoder,
     int8_t alignas(int32_t) pcm[2 * LC3_MAX_FRAME_SAMPLES*4];
     lc3_decoder_t dec[2];
 
-    int frame_samples = lc3_frame_samples(frame_us, pcm_srate_hz);
+    int frame_samples = lc3_frame_samples(frame_us, dec_srate_hz);
     int encode_samples = pcm_samples + lc3_delay_samples(frame_us, pcm_srate_hz);
     enum lc3_pcm_format pcm_fmt = (pcm_sbits == 24) ? LC3_PCM_FORMAT_S24_3LE : LC3_PCM_FORMAT_S16;
 
     for (int ich = 0; ich < nch; ich++){
         dec[ich] = lc3_setup_decoder(frame_us,
                                      srate_hz,
-                                     dstate_hz,
-                                     malloc(lc3_decoder_size(frame_us, pcm_srate_hz)));
+                                     dec_srate_hz,
+                                     lc3_pool_get(decoder->pool,
+                                         lc3_decoder_size(frame_us,
+                                         srate_hz > dec_srate_hz ?
+                                         srate_hz : dec_srate_hz)));
+    }
+
+    for (int ich = 0; ich < nch; ich++){
+        if(NULL == dec[ich]){
+            for (int jch = 0; jch < nch; jch++){
+                lc3_pool_put(decoder->pool, dec[jch]);
+            }
+            return ILC3_BAD_ARG;
+        }
+    }
+
+    /* the frames to resample are decoded as float samples */
+    resample_coder_t rc = { 0 };
+    if(resample){
+        if(0 != resample_coder_init(&rc, dec_srate_hz, pcm_srate_hz, nch, pcm_fmt, frame_samples)){
+            for (int ich = 0; ich < nch; ich++){
+                lc3_pool_put(decoder->pool, dec[ich]);
+            }
+            return ILC3_BAD_ARG;
+        }
     }
 
     /* --- Decoding loop --- */
 
-    for (int i = 0; i * frame_samples < encode_samples; i++) {
+    int nwritten = 0;
+    ilc3_res_t res = ILC3_OK;
+
+    for (int i = 0; resample ? nwritten < pcm_samples :
+                               i * frame_samples < encode_samples; i++) {
+        const enum lc3_pcm_format dec_fmt = resample ? LC3_PCM_FORMAT_FLOAT : pcm_fmt;
+        const int dec_sbytes = resample ? (int)sizeof(float) : pcm_sbytes;
+
         int frame_bytes = lc3bin_bread_data(fp_in, nch, in);
         if (frame_bytes <= 0){
-            memset(pcm, 0, nch * frame_samples * pcm_sbytes);
+            memset(pcm, 0, nch * frame_samples * dec_sbytes);
         } else {
             for (int ich = 0; ich < nch; ich++){
                 lc3_decode(dec[ich],
                            in + ich * frame_bytes,
                            frame_bytes,
-                           pcm_fmt,
-                           pcm + ich * pcm_sbytes,
+                           dec_fmt,
+                           pcm + ich * dec_sbytes,
                            nch);
             }
         }
 
-        int pcm_offset = i > 0 ? 0 : encode_samples - pcm_samples;
-        int pcm_nwrite = MIN((frame_samples - pcm_offset), (encode_samples - i*frame_samples));
+        const int8_t * out = NULL;
+        int pcm_nwrite = 0;
 
+        if(resample){
+            const int offset = i > 0 ? 0 : lc3_delay_samples(frame_us, dec_srate_hz);
+            pcm_nwrite = resample_coder_to_pcm(&rc,
+                                               (const float *)pcm + nch * offset,
+                                               frame_samples - offset,
+                                               pcm_samples - nwritten);
+            out = rc.pcm;
+        } else {
+            int pcm_offset = i > 0 ? 0 : encode_samples - pcm_samples;
+            pcm_nwrite = MIN((frame_samples - pcm_offset), (encode_samples - i*frame_samples));
+            out = pcm + nch * pcm_offset * pcm_sbytes;
+        }
+
+        nwritten += pcm_nwrite;
+        if(0 == pcm_nwrite){
+            continue;
+        }
         
-        const int wres = bwrite((uint8_t *)pcm + nch * pcm_offset * pcm_sbytes, nch * pcm_sbytes, pcm_nwrite, fp_out);
+        const int wres = bwrite((const uint8_t *)out, nch * pcm_sbytes, pcm_nwrite, fp_out);
         if(0 > wres){
             ERROR("in bstream not enought space\n");
-            for (int ich = 0; ich < nch; ich++){
-                free(dec[ich]);
-            }
-            return ILC3_BAD_INOUT;
+            res = ILC3_BAD_INOUT;
+            break;
         }
     }
 
     /* --- Cleanup --- */
 
     for (int ich = 0; ich < nch; ich++){
-        free(dec[ich]);
+        lc3_pool_put(decoder->pool, dec[ich]);
+    }
+
+    resample_coder_free(&rc);
+
+    if(ILC3_OK != res){
+        return res;
     }
 
     return ILC3_OK + (out_siz - fp_out->bsiz);
 }
 
 
+/**
+ * return the exact size of the output of `stream_to_lc3`
+ * return size in bytes or error codes
+*/
+ilc3_res_t lc3_stream_encoded_size(const ilc3_coder_t * const encoder,
+                                   const uint8_t * const fin,
+                                   const uint32_t in_siz,
+                                   const bool with_hdr)
+{
+    uint32_t framesize = 0;
+    int srate_hz = 0;
+    int nch = 0;
+    int nsamples = 0;
+    int pcm_sbits = 0;
+
+    if(with_hdr){
+        bstream_t f_in;
+        bstream_t * const fp_in = &f_in;
+        const int bin_init_res = binit(fp_in, fin, in_siz, BM_READ);
+        if(0 != bin_init_res){
+            ERROR("can't init in bstream\n");
+            return ILC3_BAD_ARG;
+        }
+
+        const int res = get_params_from_hdr(fp_in, &framesize, &srate_hz, &nch, &nsamples, &pcm_sbits);
+        if(0 != res){
+            return res;
+        }
+    } else {
+        nch = encoder->nch;
+        pcm_sbits = encoder->samplesiz;
+        framesize = nch * (pcm_sbits / 8);
+        srate_hz = encoder->srate_hz;
+        if(0 == framesize){
+            return ILC3_BAD_ARG;
+        }
+        nsamples = in_siz / framesize;
+    }
+
+    if(nch < 1){
+        return ILC3_BAD_ARG;
+    }
+
+    /* the frames are counted at the samplerate given to the encoder,
+     * the resampled one when the encoder can't downsample itself */
+    const int encoder_srate = encoder->srate_hz;
+    const int enc_srate_hz = LC3_CHECK_SR_HZ(encoder_srate) ?
+        encoder_srate : resample_lc3_hz(srate_hz);
+    if(0 == enc_srate_hz){
+        return ILC3_BAD_ARG;
+    }
+
+    int pcm_srate_hz = srate_hz;
+    int pcm_samples = nsamples;
+    if(!resample_lc3_native(enc_srate_hz, srate_hz) || enc_srate_hz > srate_hz){
+        pcm_srate_hz = enc_srate_hz;
+        pcm_samples = ((int64_t)nsamples * pcm_srate_hz) / srate_hz;
+    }
+
+    const int frame_us = encoder->frame_us;
+    const int frame_samples = lc3_frame_samples(frame_us, pcm_srate_hz);
+    const int frame_bytes = lc3_frame_bytes_ex(frame_us, enc_srate_hz, encoder->bitrate / nch);
+    if(0 >= frame_samples || 0 >= frame_bytes){
+        ERROR("bad coder params\n");
+        return ILC3_BAD_ARG;
+    }
+
+    const int encode_samples = pcm_samples + lc3_delay_samples(frame_us, pcm_srate_hz);
+    const int nframes = (encode_samples + frame_samples - 1) / frame_samples;
+    const int64_t size = LC3_HDR_SIZ +
+        (int64_t)nframes * (sizeof(uint16_t) + nch * frame_bytes);
+
+    if(INT32_MAX < size){
+        return ILC3_BAD_INOUT;
+    }
+
+    return ILC3_OK + size;
+}
+
+
+/**
+ * return the exact size of the output of `lc3_to_stream`
+ * return size in bytes or error codes
+*/
+ilc3_res_t lc3_stream_decoded_size(const ilc3_coder_t * const decoder,
+                                   const uint8_t * const fin,
+                                   const uint32_t in_siz)
+{
+    bstream_t f_in;
+    bstream_t * const fp_in = &f_in;
+    const int bin_init_res = binit(fp_in, fin, in_siz, BM_READ);
+    if(0 != bin_init_res){
+        return ILC3_BAD_ARG;
+    }
+
+    int frame_us, srate_hz, nch, nsamples;
+
+    if (0 != lc3bin_bread_header(fp_in, &frame_us, &srate_hz, &nch, &nsamples)){
+        return ILC3_BAD_ARG;
+    }
+
+    if (nch  < 1 || nch  > 2){
+        return ILC3_BAD_ARG;
+    }
+
+    if (!LC3_CHECK_DT_US(frame_us)){
+        return ILC3_BAD_ARG;
+    }
+
+    const int dstate_hz = decoder->srate_hz;
+    if (!LC3_CHECK_SR_HZ(srate_hz) || (dstate_hz && !ILC3_CHECK_SR_HZ(dstate_hz))){
+        return ILC3_BAD_ARG;
+    }
+
+    const int pcm_sbytes = decoder->samplesiz / 8;
+    const int pcm_srate_hz = !dstate_hz ? srate_hz : dstate_hz;
+    const int pcm_samples = !dstate_hz ? nsamples :
+        ((int64_t)nsamples * pcm_srate_hz) / srate_hz;
+
+    const int64_t size = WAVE_HEADER_SIZ +
+        (int64_t)pcm_samples * nch * pcm_sbytes;
+
+    if(INT32_MAX < size){
+        return ILC3_BAD_INOUT;
+    }
+
+    return ILC3_OK + size;
+}
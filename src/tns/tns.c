@@ -352,7 +352,8 @@ void lc3_tns_analyze(enum lc3_dt dt, enum lc3_bandwidth bw,
     data->nfilters = 1 + (bw >= LC3_BANDWIDTH_SWB);
     data->lpc_weighting = resolve_lpc_weighting(dt, nbytes);
 
-    compute_lpc_coeffs(dt, bw, x, pred_gain, a);
+    if (!nn_flag)
+        compute_lpc_coeffs(dt, bw, x, pred_gain, a);
 
     for (int f = 0; f < data->nfilters; f++) {
 
@@ -411,6 +412,14 @@ int lc3_tns_get_nbits(const struct lc3_tns_data *data)
     return nbits;
 }
 
+/**
+ * Adapt bitstream data to a size of frame
+ */
+void lc3_tns_set_nbytes(enum lc3_dt dt, int nbytes, struct lc3_tns_data *data)
+{
+    data->lpc_weighting = resolve_lpc_weighting(dt, nbytes);
+}
+
 /**
  * Put bitstream data
  */
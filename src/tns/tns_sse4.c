@@ -0,0 +1,31 @@
+/******************************************************************************
+ *
+ *  Copyright 2022 Google LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/**
+ * Build of the module for the SSE4.1 processor level,
+ * the exported symbols are suffixed by the name of the level.
+ */
+
+#define lc3_tns_analyze          lc3_tns_analyze_sse4
+#define lc3_tns_get_nbits        lc3_tns_get_nbits_sse4
+#define lc3_tns_set_nbytes       lc3_tns_set_nbytes_sse4
+#define lc3_tns_put_data         lc3_tns_put_data_sse4
+#define lc3_tns_get_data         lc3_tns_get_data_sse4
+#define lc3_tns_synthesize       lc3_tns_synthesize_sse4
+
+#include "tns.c"
@@ -0,0 +1,560 @@
+/******************************************************************************
+ *
+ *  Copyright 2022 Google LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/**
+ * LC3 - Benchmark of the encoding and decoding stages
+ *
+ * Each configuration is run through the public `lc3_encode()` and
+ * `lc3_decode()`, timed for the overall figures. The figures of the stages
+ * are read from `lc3_encoder_stats()` and `lc3_decoder_stats()`, so that
+ * the library is built with `LC3_PROFILE` defined (`make PROFILE=1`).
+ * The results are written in JSON.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <errno.h>
+
+#include <lc3.h>
+
+#include "wave.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+
+/**
+ * Error handling
+ */
+
+static void error(int status, const char *format, ...)
+{
+    va_list args;
+
+    fflush(stdout);
+
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+
+    fprintf(stderr, status ? ": %s\n" : "\n", strerror(status));
+    exit(status);
+}
+
+
+/**
+ * Parameters
+ */
+
+struct parameters {
+    const char *fname_out;
+    const char *fname_wav[8];
+    int nwav;
+    int nframes;
+};
+
+static struct parameters parse_args(int argc, char *argv[])
+{
+    static const char *usage =
+        "Usage: %s [options] [wav_file...]\n"
+        "\n"
+        "wav_file\t"  "16 bits wave files used as real signals\n"
+        "\n"
+        "Options:\n"
+        "\t-h\t"     "Display help\n"
+        "\t-n\t"     "Number of frames by configuration (default 200)\n"
+        "\t-o\t"     "Output JSON file, stdout if omitted\n"
+        "\n";
+
+    struct parameters p = { .nframes = 200 };
+
+    for (int iarg = 1; iarg < argc; ) {
+        const char *arg = argv[iarg++];
+
+        if (arg[0] == '-') {
+            if (arg[2] != '\0')
+                error(EINVAL, "Option %s", arg);
+
+            char opt = arg[1];
+            const char *optarg = NULL;
+
+            switch (opt) {
+                case 'n': case 'o':
+                    if (iarg >= argc)
+                        error(EINVAL, "Argument %s", arg);
+                    optarg = argv[iarg++];
+            }
+
+            switch (opt) {
+                case 'h': fprintf(stderr, usage, argv[0]); exit(0);
+                case 'n': p.nframes = atoi(optarg); break;
+                case 'o': p.fname_out = optarg; break;
+                default:
+                    error(EINVAL, "Option %s", arg);
+            }
+
+        } else {
+
+            if (p.nwav >= (int)(sizeof(p.fname_wav) / sizeof(*p.fname_wav)))
+                error(EINVAL, "Argument %s", arg);
+
+            p.fname_wav[p.nwav++] = arg;
+        }
+    }
+
+    if (p.nframes <= 0)
+        error(EINVAL, "Number of frames %d", p.nframes);
+
+    return p;
+}
+
+
+/* ----------------------------------------------------------------------------
+ *  Timing
+ * -------------------------------------------------------------------------- */
+
+/**
+ * Timestamp, in ns and in cycles of the timestamp counter
+ * The cycles are left to 0, when no counter is available
+ */
+
+struct stamp {
+    long long ns;
+    unsigned long long cycles;
+};
+
+static struct stamp stamp(void)
+{
+    struct timespec ts;
+    struct stamp s;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    s.ns = (long long)ts.tv_sec * 1000*1000*1000 + ts.tv_nsec;
+
+#if defined(__x86_64__) || defined(__i386__)
+    s.cycles = __rdtsc();
+#else
+    s.cycles = 0;
+#endif
+
+    return s;
+}
+
+
+/**
+ * Names of the stages, reported by the statistics of the library
+ */
+
+static const char *encoder_stage_names[LC3_NUM_ENCODER_STAGE] = {
+    [LC3_ENCODER_STAGE_ATTDET] = "attdet",
+    [LC3_ENCODER_STAGE_LTPF  ] = "ltpf",
+    [LC3_ENCODER_STAGE_MDCT  ] = "mdct",
+    [LC3_ENCODER_STAGE_ENERGY] = "energy",
+    [LC3_ENCODER_STAGE_BWDET ] = "bwdet",
+    [LC3_ENCODER_STAGE_SNS   ] = "sns",
+    [LC3_ENCODER_STAGE_TNS   ] = "tns",
+    [LC3_ENCODER_STAGE_SPEC  ] = "spec",
+    [LC3_ENCODER_STAGE_ENCODE] = "encode",
+};
+
+static const char *decoder_stage_names[LC3_NUM_DECODER_STAGE] = {
+    [LC3_DECODER_STAGE_DECODE] = "decode",
+    [LC3_DECODER_STAGE_TNS   ] = "tns",
+    [LC3_DECODER_STAGE_PLC   ] = "plc",
+    [LC3_DECODER_STAGE_SNS   ] = "sns",
+    [LC3_DECODER_STAGE_MDCT  ] = "mdct",
+    [LC3_DECODER_STAGE_LTPF  ] = "ltpf",
+};
+
+/**
+ * Timing of a direction, overall and by stage
+ * The cycles of the stages not counted by the library (PCM conversion,
+ * setup of the bitstream) are reported as the stage `other`
+ */
+
+struct timing {
+    long long ns;
+    unsigned long long cycles;
+
+    int nstages;
+    const char * const *stage_names;
+    const uint64_t *stage_cycles;
+};
+
+
+/* ----------------------------------------------------------------------------
+ *  Signals
+ * -------------------------------------------------------------------------- */
+
+/**
+ * Signal, as 16 bits samples
+ */
+
+struct signal {
+    const char *name;
+    int16_t *x;
+    int n;
+};
+
+/**
+ * Generate a logarithmic sweep, from 20 Hz to Nyquist, over white noise
+ * sr_hz           Samplerate
+ * n               Number of samples
+ * x               Output samples
+ */
+static void generate_sweep(int sr_hz, int n, int16_t *x)
+{
+    const double pi = 3.14159265358979;
+    double f0 = 20, f1 = sr_hz / 2;
+    double k = log(f1 / f0) / n;
+    unsigned seed = 1;
+
+    for (int i = 0; i < n; i++) {
+        double phi = 2 * pi * f0 / (k * sr_hz) * (exp(k * i) - 1);
+        seed = seed * 1103515245 + 12345;
+
+        x[i] = (int16_t)(16384 * sin(phi) +
+            (int)((seed >> 16) & 0x3ff) - 512);
+    }
+}
+
+/**
+ * Generate white noise
+ * n               Number of samples
+ * x               Output samples
+ */
+static void generate_noise(int n, int16_t *x)
+{
+    unsigned seed = 1;
+
+    for (int i = 0; i < n; i++) {
+        seed = seed * 1103515245 + 12345;
+        x[i] = (int16_t)((int)((seed >> 12) & 0x3fff) - 0x2000);
+    }
+}
+
+/**
+ * Read the first channel of a 16 bits wave file
+ * fname           File name
+ * return          Signal read
+ */
+static struct signal read_wav(const char *fname)
+{
+    FILE *fp = fopen(fname, "rb");
+    if (!fp)
+        error(errno, "%s", fname);
+
+    uint8_t raw[WAVE_HEADER_SIZ];
+    struct wave_header hdr;
+
+    if (fread(raw, 1, sizeof(raw), fp) != sizeof(raw) ||
+            wave_header_read(raw, sizeof(raw), &hdr) < 0 ||
+            hdr.format.bitdepth != 16 || hdr.format.channels < 1)
+        error(EINVAL, "Bad file format: %s", fname);
+
+    int nch = hdr.format.channels;
+    int n = hdr.data.size / (2 * nch);
+
+    int16_t *pcm = malloc(n * nch * sizeof(*pcm));
+    if (!pcm)
+        error(ENOMEM, "%s", fname);
+
+    n = fread(pcm, 2 * nch, n, fp);
+    fclose(fp);
+
+    for (int i = 0; i < n; i++)
+        pcm[i] = pcm[i * nch];
+
+    const char *name = strrchr(fname, '/');
+    return (struct signal){ .name = name ? name + 1 : fname, .x = pcm, .n = n };
+}
+
+
+/* ----------------------------------------------------------------------------
+ *  Benchmark
+ * -------------------------------------------------------------------------- */
+
+/**
+ * Configuration of a run
+ */
+
+struct config {
+    const struct signal *signal;
+    int dt_us, sr_hz;
+    const char *rate_name;
+    int bitrate;
+    enum lc3_pcm_format fmt;
+};
+
+static const char *format_names[] = {
+    [LC3_PCM_FORMAT_S16    ] = "s16",
+    [LC3_PCM_FORMAT_S24    ] = "s24",
+    [LC3_PCM_FORMAT_S24_3LE] = "s24_3le",
+    [LC3_PCM_FORMAT_FLOAT  ] = "float",
+};
+
+static const char *cpu_level_names[] = {
+    [LC3_CPU_GENERIC] = "generic",
+    [LC3_CPU_SSE4   ] = "sse4",
+    [LC3_CPU_AVX2   ] = "avx2",
+};
+
+/**
+ * Print the results of a direction of a run
+ * fp              Output file
+ * name            Name of the direction
+ * nframes         Number of frames run
+ * t               Timing of the direction
+ *
+ * The cycles of the stages are converted in ns with the ratio of the
+ * overall figures, when the timestamp counter is available.
+ */
+static void print_results(FILE *fp, const char *name,
+    int nframes, const struct timing *t)
+{
+    double ns = (double)t->ns / nframes;
+    double ns_per_cycle = t->cycles ? (double)t->ns / t->cycles : 0;
+
+    fprintf(fp, "      \"%s\": {\n", name);
+    fprintf(fp, "        \"ns_per_frame\": %.1f,\n", ns);
+    fprintf(fp, "        \"frames_per_s\": %.1f,\n", 1e9 / ns);
+    fprintf(fp, "        \"cycles_per_frame\": %.1f,\n",
+        (double)t->cycles / nframes);
+    fprintf(fp, "        \"stages\": {");
+
+    unsigned long long other = t->cycles;
+    const char *sep = "\n";
+
+    for (int i = 0; i <= t->nstages; i++) {
+        unsigned long long cycles;
+
+        if (i < t->nstages) {
+            cycles = t->stage_cycles[i];
+            other -= cycles < other ? cycles : other;
+        } else
+            cycles = other;
+
+        if (!cycles)
+            continue;
+
+        fprintf(fp, "%s          \"%s\": { \"ns_per_frame\": %.1f, "
+                    "\"cycles_per_frame\": %.1f }", sep,
+            i < t->nstages ? t->stage_names[i] : "other",
+            cycles * ns_per_cycle / nframes, (double)cycles / nframes);
+        sep = ",\n";
+    }
+
+    fprintf(fp, "\n        }\n      }");
+}
+
+/**
+ * Run a configuration
+ * fp              Output file
+ * c               Configuration
+ * nframes         Number of frames
+ */
+static void run(FILE *fp, const struct config *c, int nframes)
+{
+    int ns = lc3_frame_samples(c->dt_us, c->sr_hz);
+    int nbytes = lc3_frame_bytes_ex(c->dt_us, c->sr_hz, c->bitrate);
+    int pcm_sbytes = c->fmt == LC3_PCM_FORMAT_S16 ? 2 : 4;
+
+    void *enc_mem = malloc(lc3_encoder_size(c->dt_us, c->sr_hz));
+    void *dec_mem = malloc(lc3_decoder_size(c->dt_us, c->sr_hz));
+    uint8_t *pcm = malloc(nframes * ns * pcm_sbytes);
+    uint8_t *out = malloc(ns * pcm_sbytes);
+    uint8_t *frames = malloc(nframes * nbytes);
+
+    if (!enc_mem || !dec_mem || !pcm || !out || !frames)
+        error(ENOMEM, "Run");
+
+    for (int i = 0; i < nframes * ns; i++) {
+        int16_t x = c->signal->x[i % c->signal->n];
+
+        switch (c->fmt) {
+        case LC3_PCM_FORMAT_S16:
+            ((int16_t *)pcm)[i] = x; break;
+        case LC3_PCM_FORMAT_S24:
+            ((int32_t *)pcm)[i] = x * 256; break;
+        default:
+            ((float *)pcm)[i] = ldexpf(x, -15); break;
+        }
+    }
+
+    /* --- Encoding --- */
+
+    struct lc3_encoder_stats enc_stats;
+    struct lc3_encoder *encoder;
+    struct stamp t0, t1;
+
+    encoder = lc3_setup_encoder(c->dt_us, c->sr_hz, 0, enc_mem);
+    t0 = stamp();
+
+    for (int i = 0; i < nframes; i++)
+        lc3_encode(encoder, c->fmt, pcm + i * ns * pcm_sbytes, 1,
+            nbytes, frames + i * nbytes);
+
+    t1 = stamp();
+
+    if (lc3_encoder_stats(encoder, &enc_stats) < 0)
+        error(ENOTSUP, "Statistics, build with `PROFILE=1`");
+
+    struct timing enc_timing = {
+        .ns = t1.ns - t0.ns, .cycles = t1.cycles - t0.cycles,
+        .nstages = LC3_NUM_ENCODER_STAGE,
+        .stage_names = encoder_stage_names,
+        .stage_cycles = enc_stats.cycles,
+    };
+
+    /* --- Decoding --- */
+
+    struct lc3_decoder_stats dec_stats;
+    struct lc3_decoder *decoder;
+
+    decoder = lc3_setup_decoder(c->dt_us, c->sr_hz, 0, dec_mem);
+    t0 = stamp();
+
+    for (int i = 0; i < nframes; i++)
+        lc3_decode(decoder, frames + i * nbytes, nbytes, c->fmt, out, 1);
+
+    t1 = stamp();
+
+    if (lc3_decoder_stats(decoder, &dec_stats) < 0)
+        error(ENOTSUP, "Statistics, build with `PROFILE=1`");
+
+    struct timing dec_timing = {
+        .ns = t1.ns - t0.ns, .cycles = t1.cycles - t0.cycles,
+        .nstages = LC3_NUM_DECODER_STAGE,
+        .stage_names = decoder_stage_names,
+        .stage_cycles = dec_stats.cycles,
+    };
+
+    /* --- Report --- */
+
+    fprintf(fp, "    {\n");
+    fprintf(fp, "      \"signal\": \"%s\",\n", c->signal->name);
+    fprintf(fp, "      \"frame_us\": %d,\n", c->dt_us);
+    fprintf(fp, "      \"samplerate\": %d,\n", c->sr_hz);
+    fprintf(fp, "      \"rate\": \"%s\",\n", c->rate_name);
+    fprintf(fp, "      \"bitrate\": %d,\n", c->bitrate);
+    fprintf(fp, "      \"frame_bytes\": %d,\n", nbytes);
+    fprintf(fp, "      \"format\": \"%s\",\n", format_names[c->fmt]);
+
+    print_results(fp, "encode", nframes, &enc_timing);
+    fprintf(fp, ",\n");
+    print_results(fp, "decode", nframes, &dec_timing);
+    fprintf(fp, "\n    }");
+
+    free(enc_mem);
+    free(dec_mem);
+    free(pcm);
+    free(out);
+    free(frames);
+}
+
+
+/**
+ * Entry point
+ */
+
+int main(int argc, char *argv[])
+{
+    static const int dt_list[] = { 7500, 10000 };
+    static const int sr_list[] = { 8000, 16000, 24000, 32000, 48000 };
+    static const struct { const char *name; int bitrate; } rate_list[] = {
+        { "low", 32000 }, { "high", 128000 } };
+    static const enum lc3_pcm_format fmt_list[] = {
+        LC3_PCM_FORMAT_S16, LC3_PCM_FORMAT_S24, LC3_PCM_FORMAT_FLOAT };
+
+    struct parameters p = parse_args(argc, argv);
+
+    FILE *fp = stdout;
+    if (p.fname_out && !(fp = fopen(p.fname_out, "w")))
+        error(errno, "%s", p.fname_out);
+
+    /* --- Signals --- */
+
+    int nsignals = 2 + p.nwav;
+    struct signal *signals = calloc(nsignals, sizeof(*signals));
+    if (!signals)
+        error(ENOMEM, "Signals");
+
+    int ns_max = lc3_frame_samples(10000, 48000);
+
+    for (int i = 0; i < 2; i++) {
+        signals[i].name = i == 0 ? "sweep" : "noise";
+        signals[i].n = p.nframes * ns_max;
+        signals[i].x = malloc(signals[i].n * sizeof(int16_t));
+        if (!signals[i].x)
+            error(ENOMEM, "Signals");
+    }
+
+    for (int i = 0; i < p.nwav; i++)
+        signals[2+i] = read_wav(p.fname_wav[i]);
+
+    /* --- Run the configurations --- */
+
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"cpu_level\": \"%s\",\n",
+        cpu_level_names[lc3_get_cpu_level()]);
+    fprintf(fp, "  \"frames\": %d,\n", p.nframes);
+    fprintf(fp, "  \"results\": [\n");
+
+    const char *sep = "";
+
+    for (int is = 0; is < (int)(sizeof(sr_list) / sizeof(*sr_list)); is++) {
+
+        generate_sweep(sr_list[is], signals[0].n, signals[0].x);
+        generate_noise(signals[1].n, signals[1].x);
+
+        for (int ig = 0; ig < nsignals; ig++)
+        for (int id = 0; id < (int)(sizeof(dt_list) / sizeof(*dt_list)); id++)
+        for (int ir = 0; ir < (int)(sizeof(rate_list) / sizeof(*rate_list)); ir++)
+        for (int ifmt = 0; ifmt < (int)(sizeof(fmt_list) / sizeof(*fmt_list)); ifmt++) {
+            struct config c = {
+                .signal = &signals[ig],
+                .dt_us = dt_list[id], .sr_hz = sr_list[is],
+                .rate_name = rate_list[ir].name,
+                .bitrate = rate_list[ir].bitrate,
+                .fmt = fmt_list[ifmt],
+            };
+
+            fprintf(fp, "%s", sep);
+            run(fp, &c, p.nframes);
+            sep = ",\n";
+        }
+    }
+
+    fprintf(fp, "\n  ]\n}\n");
+
+    if (fp != stdout)
+        fclose(fp);
+
+    for (int i = 0; i < nsignals; i++)
+        free(signals[i].x);
+    free(signals);
+
+    return 0;
+}
@@ -137,7 +137,7 @@ int main(int argc, char *argv[])
     /* --- Read parameters --- */
     struct parameters p = parse_args(argc, argv);
 
-    if (p.srate_hz && !LC3_CHECK_SR_HZ(p.srate_hz))
+    if (p.srate_hz && !ILC3_CHECK_SR_HZ(p.srate_hz))
         error(EINVAL, "Samplerate %d Hz", p.srate_hz);
 
     if (p.bitdepth && p.bitdepth != 16 && p.bitdepth != 24)
@@ -74,7 +74,8 @@ static struct parameters parse_args(int argc, char *argv[])
         "\t-h\t"     "Display help\n"
         "\t-b\t"     "Bitrate in bps (mandatory)\n"
         "\t-m\t"     "Frame duration in ms (default 10)\n"
-        "\t-r\t"     "Encoder samplerate (default is input samplerate)\n"
+        "\t-r\t"     "Encoder samplerate (default is input samplerate,\n"
+        "\t\t"      "or the closest higher LC3 one when resampled)\n"
         "\n";
 
     struct parameters p = { .frame_ms = 10 };
@@ -18,7 +18,7 @@ elc3_src += \
     $(TOOLS_DIR)/elc3.c
 
 elc3_lib += liblc3
-elc3_ldlibs += m
+elc3_ldlibs += m pthread
 elc3_ldflags += -flto
 
 $(eval $(call add-bin,elc3))
@@ -28,11 +28,27 @@ dlc3_src += \
     $(TOOLS_DIR)/dlc3.c
 
 dlc3_lib += liblc3
-dlc3_ldlibs += m
+dlc3_ldlibs += m pthread
 elc3_ldflags += -flto
 
 $(eval $(call add-bin,dlc3))
 
 
+lc3bench_src += \
+    $(TOOLS_DIR)/bench.c
+
+lc3bench_lib += liblc3
+lc3bench_ldlibs += m pthread
+
+$(eval $(call add-bin,lc3bench))
+
+
 .PHONY: tools
 tools: elc3 dlc3
+
+
+.PHONY: bench
+bench: lc3bench
+	@echo "  BENCH   $(BIN_DIR)/bench.json"
+	$(V)$(lc3bench_bin) -n $(or $(BENCH_FRAMES),200) \
+	    -o $(BIN_DIR)/bench.json $(BENCH_WAV)